@@ -1,31 +1,59 @@
 #ifndef _CALICO_
 #define _CALICO_
 
+#include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
 #include <any>
 #include <array>
 #include <bitset>
+#include <chrono>
 #include <deque>
+#include <filesystem>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
+#include <new>
 #include <optional>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <typeinfo>
+#include <type_traits>
 #include <typeindex>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 
 #include "util/types.hpp"
+#include "util/arena.hpp"
+#include "util/paged_array.hpp"
+#include "util/thread_pool.hpp"
+#include "util/type_id.hpp"
+#include "util/parallel_for.hpp"
+#include "util/mpsc_queue.hpp"
+#include "util/delegate.hpp"
+#include "util/file_watcher.hpp"
+#include "util/mapped_file.hpp"
 #include "logger/logger.hpp"
 
+#include "asset/asset_handle.hpp"
+#include "asset/asset_loader.hpp"
+#include "ecs/sparse_set.hpp"
 #include "ecs/component_manager.hpp"
+#include "ecs/archetype_manager.hpp"
 #include "ecs/entity_manager.hpp"
 #include "ecs/event_manager.hpp"
 #include "ecs/system_manager.hpp"
+#include "ecs/view.hpp"
+#include "ecs/command_buffer.hpp"
 #include "ecs/asset_manager.hpp"
 #include "ecs/ecs_manager.hpp"
 
@@ -1,12 +1,24 @@
 #ifndef _CALICO_OPENGL_RENDERER_HPP_
 #define _CALICO_OPENGL_RENDERER_HPP_
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <set>
+#include <utility>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <typeinfo>
 #include <typeindex>
 #include <unordered_map>
@@ -27,6 +39,9 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "util/delegate.hpp"
+#include "util/radix_sort.hpp"
+
 using vao_t = uint32_t;
 using vbo_t = uint32_t;
 using ebo_t = uint32_t;
@@ -37,9 +52,15 @@ using vertex_t = float;
 using index_t = uint32_t;
 
 #include "renderer/opengl/debug.hpp"
+#include "renderer/opengl/state_cache.hpp"
+#include "renderer/opengl/stream_buffer.hpp"
+#include "renderer/opengl/block_layout.hpp"
 #include "renderer/opengl/uniform_buffer.hpp"
 #include "renderer/opengl/shader.hpp"
 #include "renderer/opengl/program.hpp"
+#include "renderer/opengl/program_loader.hpp"
 #include "renderer/opengl/vertex_buffer.hpp"
+#include "renderer/opengl/render_queue.hpp"
+#include "renderer/opengl/instance_batcher.hpp"
 
 #endif // _CALICO_OPENGL_RENDERER_HPP_
\ No newline at end of file
@@ -0,0 +1,474 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "asset/asset_cache.hpp"
+#include "logger/errors.hpp"
+#include "xml/parsers.hpp"
+
+using namespace Calico;
+
+// Builds the tables of a cache in memory before they are written out
+struct CacheWriter {
+    std::vector<Cache::Material> materials = {};
+    std::vector<Cache::Property> properties = {};
+    std::vector<Cache::Program> programs = {};
+    std::vector<Cache::Shader> shaders = {};
+    std::vector<Cache::Uniform> uniforms = {};
+    std::vector<Cache::String> uniform_buffers = {};
+    std::vector<char> strings = {};
+    std::unordered_map<std::string, Cache::String> interned = {};
+
+    Cache::String string(const std::string &value) {
+        auto existing = interned.find(value);
+        if (existing != interned.end()) {
+            return existing->second;
+        }
+
+        Cache::String string = {
+            .offset = static_cast<std::uint32_t>(strings.size()),
+            .length = static_cast<std::uint32_t>(value.size()),
+        };
+
+        strings.insert(strings.end(), value.begin(), value.end());
+        strings.push_back('\0');
+        interned.insert({ value, string });
+        return string;
+    }
+
+    template <typename T>
+    static std::vector<std::string> sorted_keys(const std::unordered_map<std::string, T> &map) {
+        std::vector<std::string> keys;
+        for (const auto &[key, value] : map) {
+            keys.push_back(key);
+        }
+
+        // keep the output independent of hash map ordering
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    void add_material(const MaterialDescriptor &material, const std::string &source) {
+        Cache::Material record = {
+            .name_id = hash_asset_name(material.name),
+            .source_hash = AssetCache::hash_file(source),
+            .name = string(material.name),
+            .shader = string(material.shader),
+            .source = string(source),
+            .properties = { static_cast<std::uint32_t>(properties.size()), 0 },
+        };
+
+        for (const auto &name : sorted_keys(material.properties)) {
+            properties.push_back({
+                .name = string(name),
+                .type = material.types.at(name),
+                .value = material.properties.at(name),
+            });
+            record.properties.count++;
+        }
+
+        materials.push_back(record);
+    }
+
+    void add_program(const ProgramDescriptor &program, const std::string &source) {
+        Cache::Program record = {
+            .name_id = hash_asset_name(program.name),
+            .source_hash = AssetCache::hash_file(source),
+            .name = string(program.name),
+            .source = string(source),
+            .shaders = { static_cast<std::uint32_t>(shaders.size()), 0 },
+            .uniforms = { static_cast<std::uint32_t>(uniforms.size()), 0 },
+            .uniform_buffers = { static_cast<std::uint32_t>(uniform_buffers.size()), 0 },
+        };
+
+        for (const auto &path : sorted_keys(program.shader_to_type)) {
+            shaders.push_back({ .path = string(path), .type = program.shader_to_type.at(path) });
+            record.shaders.count++;
+        }
+
+        for (const auto &name : sorted_keys(program.uniforms)) {
+            uniforms.push_back({ .name = string(name), .type = string(program.uniforms.at(name)) });
+            record.uniforms.count++;
+        }
+
+        for (const auto &buffer : program.uniform_buffers) {
+            uniform_buffers.push_back(string(buffer));
+            record.uniform_buffers.count++;
+        }
+
+        programs.push_back(record);
+    }
+
+    template <typename T>
+    static Cache::Table append(std::vector<std::byte> &out, const std::vector<T> &records) {
+        out.resize((out.size() + 7) / 8 * 8);
+
+        Cache::Table table = { .offset = out.size(), .count = records.size() };
+        out.resize(out.size() + records.size() * sizeof(T));
+        if (!records.empty()) {
+            std::memcpy(out.data() + table.offset, records.data(), records.size() * sizeof(T));
+        }
+
+        return table;
+    }
+
+    std::vector<std::byte> write() {
+        auto by_name = [](const auto &lhs, const auto &rhs) { return lhs.name_id < rhs.name_id; };
+        std::sort(materials.begin(), materials.end(), by_name);
+        std::sort(programs.begin(), programs.end(), by_name);
+
+        std::vector<std::byte> out(sizeof(Cache::Header));
+        Cache::Header header = {};
+        std::memcpy(header.magic, Cache::Magic, sizeof(header.magic));
+        header.version = Cache::Version;
+        header.byte_order = Cache::Byte_Order;
+        header.materials = append(out, materials);
+        header.properties = append(out, properties);
+        header.programs = append(out, programs);
+        header.shaders = append(out, shaders);
+        header.uniforms = append(out, uniforms);
+        header.uniform_buffers = append(out, uniform_buffers);
+        header.strings = append(out, strings);
+
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+};
+
+template <typename T>
+static bool table_in_bounds(const Cache::Table &table, std::size_t size) {
+    return table.offset % alignof(T) == 0
+        && table.offset <= size
+        && table.count <= (size - table.offset) / sizeof(T);
+}
+
+static bool range_in_bounds(Cache::Range range, const Cache::Table &table) {
+    return range.first <= table.count && range.count <= table.count - range.first;
+}
+
+static bool string_in_bounds(Cache::String string, const Cache::Table &strings) {
+    return string.offset <= strings.count && string.length <= strings.count - string.offset;
+}
+
+// Compared unsigned so that negative values read from a corrupt file fail too
+template <typename Enum>
+static bool enum_in_bounds(Enum value, Enum last) {
+    return static_cast<std::uint32_t>(value) <= static_cast<std::uint32_t>(last);
+}
+
+static MappedFile open_cache(const std::string &path) {
+    try {
+        return MappedFile(path);
+    } catch (const std::runtime_error &) {
+        throw RuntimeError("Unable to open asset cache '" + path + "'");
+    }
+}
+
+AssetCache::AssetCache(const std::string &path)
+    : file(open_cache(path)),
+      data(reinterpret_cast<const std::byte*>(file.data())),
+      size(file.size()) {
+
+    if (size < sizeof(Cache::Header) || std::memcmp(header().magic, Cache::Magic, sizeof(Cache::Magic)) != 0) {
+        throw RuntimeError("'" + path + "' is not an asset cache");
+    }
+
+    const auto &header = this->header();
+
+    if (header.version != Cache::Version || header.byte_order != Cache::Byte_Order) {
+        throw RuntimeError("Asset cache '" + path + "' was cooked by another version or platform, recook it");
+    }
+
+    if (!table_in_bounds<Cache::Material>(header.materials, size)
+        || !table_in_bounds<Cache::Property>(header.properties, size)
+        || !table_in_bounds<Cache::Program>(header.programs, size)
+        || !table_in_bounds<Cache::Shader>(header.shaders, size)
+        || !table_in_bounds<Cache::Uniform>(header.uniforms, size)
+        || !table_in_bounds<Cache::String>(header.uniform_buffers, size)
+        || !table_in_bounds<char>(header.strings, size)) {
+        throw RuntimeError("Asset cache '" + path + "' is truncated");
+    }
+
+    // the views index records and strings without checking, so check every one here
+    auto check = [&path](bool valid) {
+        if (!valid) {
+            throw RuntimeError("Asset cache '" + path + "' is corrupt");
+        }
+    };
+
+    const auto &strings = header.strings;
+
+    const auto *materials = table<Cache::Material>(header.materials);
+    for (std::size_t i = 0; i < header.materials.count; i++) {
+        check(string_in_bounds(materials[i].name, strings)
+            && string_in_bounds(materials[i].shader, strings)
+            && string_in_bounds(materials[i].source, strings)
+            && range_in_bounds(materials[i].properties, header.properties));
+    }
+
+    const auto *properties = table<Cache::Property>(header.properties);
+    for (std::size_t i = 0; i < header.properties.count; i++) {
+        check(string_in_bounds(properties[i].name, strings)
+            && enum_in_bounds(properties[i].type, MaterialDescriptor::PropertyType::Mat4));
+    }
+
+    const auto *programs = table<Cache::Program>(header.programs);
+    for (std::size_t i = 0; i < header.programs.count; i++) {
+        check(string_in_bounds(programs[i].name, strings)
+            && string_in_bounds(programs[i].source, strings)
+            && range_in_bounds(programs[i].shaders, header.shaders)
+            && range_in_bounds(programs[i].uniforms, header.uniforms)
+            && range_in_bounds(programs[i].uniform_buffers, header.uniform_buffers));
+    }
+
+    const auto *shaders = table<Cache::Shader>(header.shaders);
+    for (std::size_t i = 0; i < header.shaders.count; i++) {
+        check(string_in_bounds(shaders[i].path, strings)
+            && enum_in_bounds(shaders[i].type, ProgramDescriptor::ShaderType::Geometry));
+    }
+
+    const auto *uniforms = table<Cache::Uniform>(header.uniforms);
+    for (std::size_t i = 0; i < header.uniforms.count; i++) {
+        check(string_in_bounds(uniforms[i].name, strings) && string_in_bounds(uniforms[i].type, strings));
+    }
+
+    const auto *uniform_buffers = table<Cache::String>(header.uniform_buffers);
+    for (std::size_t i = 0; i < header.uniform_buffers.count; i++) {
+        check(string_in_bounds(uniform_buffers[i], strings));
+    }
+}
+
+template <typename Record>
+static const Record *find_record(const Record *records, std::size_t count, std::string_view name,
+    const auto &name_of) {
+
+    AssetNameID id = hash_asset_name(name);
+    const Record *end = records + count;
+    const Record *record = std::lower_bound(records, end, id,
+        [](const Record &record, AssetNameID id) { return record.name_id < id; });
+
+    // names with the same hash are adjacent
+    for (; record != end && record->name_id == id; record++) {
+        if (name_of(*record) == name) {
+            return record;
+        }
+    }
+
+    return nullptr;
+}
+
+std::optional<MaterialDescriptorView> AssetCache::find_material(std::string_view name) const noexcept {
+    const auto *record = find_record(table<Cache::Material>(header().materials), header().materials.count,
+        name, [this](const Cache::Material &material) { return string(material.name); });
+
+    if (!record) {
+        return std::nullopt;
+    }
+
+    return MaterialDescriptorView(*this, *record);
+}
+
+std::optional<ProgramDescriptorView> AssetCache::find_program(std::string_view name) const noexcept {
+    const auto *record = find_record(table<Cache::Program>(header().programs), header().programs.count,
+        name, [this](const Cache::Program &program) { return string(program.name); });
+
+    if (!record) {
+        return std::nullopt;
+    }
+
+    return ProgramDescriptorView(*this, *record);
+}
+
+std::size_t AssetCache::material_count() const noexcept {
+    return header().materials.count;
+}
+
+std::size_t AssetCache::program_count() const noexcept {
+    return header().programs.count;
+}
+
+std::uint64_t AssetCache::hash_file(const std::string &path) {
+    try {
+        return hash_asset_name(MappedFile(path).view());
+    } catch (const std::runtime_error &) {
+        return 0;
+    }
+}
+
+bool AssetCache::is_current(std::string_view source, std::uint64_t source_hash) {
+    return hash_file(std::string(source)) == source_hash;
+}
+
+std::vector<std::string> AssetCache::stale_sources() const {
+    std::vector<std::string> stale;
+
+    const auto *materials = table<Cache::Material>(header().materials);
+    for (std::size_t i = 0; i < header().materials.count; i++) {
+        if (!is_current(string(materials[i].source), materials[i].source_hash)) {
+            stale.emplace_back(string(materials[i].source));
+        }
+    }
+
+    const auto *programs = table<Cache::Program>(header().programs);
+    for (std::size_t i = 0; i < header().programs.count; i++) {
+        if (!is_current(string(programs[i].source), programs[i].source_hash)) {
+            stale.emplace_back(string(programs[i].source));
+        }
+    }
+
+    return stale;
+}
+
+void AssetCache::cook(
+    const std::vector<std::string> &material_files,
+    const std::vector<std::string> &program_files,
+    const std::string &output) {
+
+    CacheWriter writer;
+    for (const auto &file : material_files) {
+        writer.add_material(XML::read_material(file), file);
+    }
+
+    for (const auto &file : program_files) {
+        writer.add_program(XML::read_program(file), file);
+    }
+
+    auto bytes = writer.write();
+
+    // write next to the output and rename over it, so a running game mapping the old
+    // cache never sees a half written file
+    std::string temporary = output + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size())) {
+            throw RuntimeError("Unable to write asset cache '" + temporary + "'");
+        }
+    }
+
+    if (std::rename(temporary.c_str(), output.c_str()) != 0) {
+        throw RuntimeError("Unable to replace asset cache '" + output + "'");
+    }
+}
+
+// MaterialDescriptorView
+
+std::string_view MaterialDescriptorView::name() const noexcept {
+    return cache->string(record->name);
+}
+
+std::string_view MaterialDescriptorView::shader() const noexcept {
+    return cache->string(record->shader);
+}
+
+std::string_view MaterialDescriptorView::source() const noexcept {
+    return cache->string(record->source);
+}
+
+std::uint64_t MaterialDescriptorView::source_hash() const noexcept {
+    return record->source_hash;
+}
+
+std::size_t MaterialDescriptorView::property_count() const noexcept {
+    return record->properties.count;
+}
+
+MaterialDescriptorView::PropertyView MaterialDescriptorView::property(std::size_t index) const noexcept {
+    const auto &property = cache->table<Cache::Property>(cache->header().properties)[record->properties.first + index];
+    return { cache->string(property.name), property.type, property.value };
+}
+
+std::optional<MaterialDescriptorView::PropertyView> MaterialDescriptorView::find_property(std::string_view name) const noexcept {
+    // properties are sorted by name
+    std::size_t first = 0;
+    std::size_t last = property_count();
+    while (first < last) {
+        std::size_t middle = first + (last - first) / 2;
+        auto candidate = property(middle);
+        if (candidate.name == name) {
+            return candidate;
+        } else if (candidate.name < name) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return std::nullopt;
+}
+
+MaterialDescriptor MaterialDescriptorView::to_descriptor() const {
+    MaterialDescriptor material;
+    material.name = name();
+    material.shader = shader();
+
+    for (std::size_t i = 0; i < property_count(); i++) {
+        auto view = property(i);
+        auto value = view.value;
+        material.add_property(std::string(view.name), view.type, std::move(value));
+    }
+
+    return material;
+}
+
+// ProgramDescriptorView
+
+std::string_view ProgramDescriptorView::name() const noexcept {
+    return cache->string(record->name);
+}
+
+std::string_view ProgramDescriptorView::source() const noexcept {
+    return cache->string(record->source);
+}
+
+std::uint64_t ProgramDescriptorView::source_hash() const noexcept {
+    return record->source_hash;
+}
+
+std::size_t ProgramDescriptorView::shader_count() const noexcept {
+    return record->shaders.count;
+}
+
+ProgramDescriptorView::ShaderView ProgramDescriptorView::shader(std::size_t index) const noexcept {
+    const auto &shader = cache->table<Cache::Shader>(cache->header().shaders)[record->shaders.first + index];
+    return { cache->string(shader.path), shader.type };
+}
+
+std::size_t ProgramDescriptorView::uniform_count() const noexcept {
+    return record->uniforms.count;
+}
+
+ProgramDescriptorView::UniformView ProgramDescriptorView::uniform(std::size_t index) const noexcept {
+    const auto &uniform = cache->table<Cache::Uniform>(cache->header().uniforms)[record->uniforms.first + index];
+    return { cache->string(uniform.name), cache->string(uniform.type) };
+}
+
+std::size_t ProgramDescriptorView::uniform_buffer_count() const noexcept {
+    return record->uniform_buffers.count;
+}
+
+std::string_view ProgramDescriptorView::uniform_buffer(std::size_t index) const noexcept {
+    return cache->string(cache->table<Cache::String>(cache->header().uniform_buffers)[record->uniform_buffers.first + index]);
+}
+
+ProgramDescriptor ProgramDescriptorView::to_descriptor() const {
+    ProgramDescriptor program;
+    program.name = name();
+
+    for (std::size_t i = 0; i < shader_count(); i++) {
+        auto view = shader(i);
+        program.shader_to_type.insert({ std::string(view.path), view.type });
+    }
+
+    for (std::size_t i = 0; i < uniform_count(); i++) {
+        auto view = uniform(i);
+        program.uniforms.insert({ std::string(view.name), std::string(view.type) });
+    }
+
+    for (std::size_t i = 0; i < uniform_buffer_count(); i++) {
+        program.uniform_buffers.emplace_back(uniform_buffer(i));
+    }
+
+    return program;
+}
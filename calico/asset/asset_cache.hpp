@@ -0,0 +1,224 @@
+#ifndef _CALICO_ASSET_CACHE_HPP_
+#define _CALICO_ASSET_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "asset/asset_handle.hpp"
+#include "asset/material.hpp"
+#include "asset/program.hpp"
+#include "util/mapped_file.hpp"
+
+namespace Calico {
+
+// Flat binary form of material and program descriptors, produced ahead of time by
+// `AssetCache::cook` and read back by mapping the file into memory. The structures
+// below are the file's layout: a `Header`, then the tables it points to, with all
+// strings in one table at the end. Everything is 8-byte aligned and stored in the
+// cooking machine's byte order, which `Header::byte_order` records.
+namespace Cache {
+
+constexpr char Magic[8] = { 'C', 'A', 'L', 'C', 'A', 'C', 'H', 'E' };
+// bump whenever the layout below changes, so old caches are rejected
+constexpr std::uint32_t Version = 1;
+constexpr std::uint32_t Byte_Order = 0x01020304;
+
+struct String {
+    // offset into the string table and length, excluding the terminating zero
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+};
+
+// Contiguous records of one table
+struct Range {
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+};
+
+struct Table {
+    std::uint64_t offset = 0;
+    std::uint64_t count = 0;
+};
+
+struct Header {
+    char magic[8] = {};
+    std::uint32_t version = 0;
+    std::uint32_t byte_order = 0;
+    Table materials = {};
+    Table properties = {};
+    Table programs = {};
+    Table shaders = {};
+    Table uniforms = {};
+    Table uniform_buffers = {};
+    Table strings = {};
+};
+
+// Materials and programs are sorted by `name_id`, the hash of their name, so they
+// can be found by binary search
+struct Material {
+    AssetNameID name_id = 0;
+    // hash of the descriptor file the material was cooked from
+    std::uint64_t source_hash = 0;
+    String name = {};
+    String shader = {};
+    String source = {};
+    Range properties = {};
+};
+
+struct Property {
+    String name = {};
+    MaterialDescriptor::PropertyType type = {};
+    std::uint32_t padding = 0;
+    MaterialDescriptor::Property value = {};
+};
+
+struct Program {
+    AssetNameID name_id = 0;
+    std::uint64_t source_hash = 0;
+    String name = {};
+    String source = {};
+    Range shaders = {};
+    Range uniforms = {};
+    Range uniform_buffers = {};
+};
+
+struct Shader {
+    String path = {};
+    ProgramDescriptor::ShaderType type = {};
+    std::uint32_t padding = 0;
+};
+
+struct Uniform {
+    String name = {};
+    String type = {};
+};
+
+}
+
+class AssetCache;
+
+// A material descriptor inside a mapped `AssetCache`. Only valid while the cache is.
+class MaterialDescriptorView {
+    const AssetCache *cache = nullptr;
+    const Cache::Material *record = nullptr;
+public:
+    struct PropertyView {
+        std::string_view name;
+        MaterialDescriptor::PropertyType type;
+        const MaterialDescriptor::Property &value;
+    };
+
+    MaterialDescriptorView(const AssetCache &cache, const Cache::Material &record)
+        : cache(&cache), record(&record) {}
+
+    std::string_view name() const noexcept;
+    std::string_view shader() const noexcept;
+    // descriptor file the material was cooked from
+    std::string_view source() const noexcept;
+    std::uint64_t source_hash() const noexcept;
+
+    std::size_t property_count() const noexcept;
+    PropertyView property(std::size_t index) const noexcept;
+    std::optional<PropertyView> find_property(std::string_view name) const noexcept;
+
+    // Copy into a `MaterialDescriptor`, for code that needs to own or modify it
+    MaterialDescriptor to_descriptor() const;
+};
+
+// A program descriptor inside a mapped `AssetCache`. Only valid while the cache is.
+class ProgramDescriptorView {
+    const AssetCache *cache = nullptr;
+    const Cache::Program *record = nullptr;
+public:
+    struct ShaderView {
+        std::string_view path;
+        ProgramDescriptor::ShaderType type;
+    };
+
+    struct UniformView {
+        std::string_view name;
+        std::string_view type;
+    };
+
+    ProgramDescriptorView(const AssetCache &cache, const Cache::Program &record)
+        : cache(&cache), record(&record) {}
+
+    std::string_view name() const noexcept;
+    std::string_view source() const noexcept;
+    std::uint64_t source_hash() const noexcept;
+
+    std::size_t shader_count() const noexcept;
+    ShaderView shader(std::size_t index) const noexcept;
+    std::size_t uniform_count() const noexcept;
+    UniformView uniform(std::size_t index) const noexcept;
+    std::size_t uniform_buffer_count() const noexcept;
+    std::string_view uniform_buffer(std::size_t index) const noexcept;
+
+    ProgramDescriptor to_descriptor() const;
+};
+
+// Read-only, memory-mapped cache of cooked descriptors.
+//
+// Opening a cache maps the file and validates its header, and that every record range
+// and string lies inside its table; finding a descriptor is a binary search over name
+// hashes, and the returned views point straight into the mapping, so nothing is parsed
+// or copied. Each entry remembers the hash of the file it was cooked from: `is_current`
+// rehashes that file so callers can fall back to the XML, and `stale_sources` lists
+// every entry that needs recooking.
+class AssetCache {
+    friend class MaterialDescriptorView;
+    friend class ProgramDescriptorView;
+
+    MappedFile file;
+    const std::byte *data = nullptr;
+    std::size_t size = 0;
+
+    const Cache::Header &header() const noexcept {
+        return *reinterpret_cast<const Cache::Header*>(data);
+    }
+
+    template <typename T>
+    const T *table(const Cache::Table &table) const noexcept {
+        return reinterpret_cast<const T*>(data + table.offset);
+    }
+
+    std::string_view string(Cache::String string) const noexcept {
+        return { table<char>(header().strings) + string.offset, string.length };
+    }
+public:
+    // Map the cache at `path`, throwing a `RuntimeError` if it can't be read or was
+    // written by another version of the cooker
+    explicit AssetCache(const std::string &path);
+
+    AssetCache(const AssetCache &rhs) = delete;
+    void operator=(const AssetCache &rhs) = delete;
+
+    std::optional<MaterialDescriptorView> find_material(std::string_view name) const noexcept;
+    std::optional<ProgramDescriptorView> find_program(std::string_view name) const noexcept;
+
+    std::size_t material_count() const noexcept;
+    std::size_t program_count() const noexcept;
+
+    // Whether the file `source` still hashes to `source_hash`
+    static bool is_current(std::string_view source, std::uint64_t source_hash);
+
+    // Descriptor files that changed since they were cooked
+    std::vector<std::string> stale_sources() const;
+
+    // FNV-1a hash of the contents of `path`, or 0 if it can't be read
+    static std::uint64_t hash_file(const std::string &path);
+
+    // Parse the given descriptor files and write them to a cache at `output`
+    static void cook(
+        const std::vector<std::string> &material_files,
+        const std::vector<std::string> &program_files,
+        const std::string &output);
+};
+
+}
+
+#endif // _CALICO_ASSET_CACHE_HPP_
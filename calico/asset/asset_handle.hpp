@@ -0,0 +1,55 @@
+#ifndef _CALICO_ASSET_HANDLE_HPP_
+#define _CALICO_ASSET_HANDLE_HPP_
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Calico {
+
+// Asset names are looked up by their 64-bit FNV-1a hash, which can be computed at
+// compile time for names known up front: `"default_mat"_asset`
+using AssetNameID = std::uint64_t;
+
+constexpr AssetNameID hash_asset_name(std::string_view name) noexcept {
+    AssetNameID hash = 0xcbf29ce484222325ull;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+namespace Literals {
+
+consteval AssetNameID operator""_asset(const char *name, std::size_t length) {
+    return hash_asset_name({ name, length });
+}
+
+}
+
+// Refers to a slot in the storage of `Asset`s of one type. Resolving a handle is an
+// index and a generation compare; the generation changes when the asset is removed,
+// so handles to removed assets resolve to nothing rather than to whatever reuses
+// their slot. Replacing an asset under the same name keeps its handles valid.
+template <typename Asset>
+struct AssetHandle {
+    std::uint32_t index = ~0u;
+    std::uint32_t generation = 0;
+
+    bool is_null() const noexcept {
+        return index == ~0u;
+    }
+
+    explicit operator bool() const noexcept {
+        return !is_null();
+    }
+
+    auto operator<=>(const AssetHandle &rhs) const = default;
+};
+
+}
+
+#endif // _CALICO_ASSET_HANDLE_HPP_
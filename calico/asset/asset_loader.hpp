@@ -0,0 +1,114 @@
+#ifndef _CALICO_ASSET_LOADER_HPP_
+#define _CALICO_ASSET_LOADER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Calico {
+
+// How an `Asset` is loaded from a file by `AssetManager::load_async`. Specializations
+// provide
+//
+//     // whatever can be produced away from the main thread, e.g. a parsed descriptor
+//     // along with the contents of the files it refers to
+//     using Intermediate = ...;
+//
+//     // called on a worker thread, throws on failure
+//     static Intermediate load(const std::string &path);
+//
+//     // called on the thread driving the `AssetManager`, for work that must happen
+//     // there such as creating GL objects; throws on failure
+//     static Asset finalize(Intermediate &&data);
+//
+// and optionally, for assets made from more than one file
+//
+//     // other files the asset was made from, watched for changes along with `path`
+//     static std::vector<std::string> dependencies(const Intermediate &data);
+//
+// and, to load whole directories of them with `AssetManager::load_directory`
+//
+//     // parse a file already in memory, called on a worker thread, throws on failure
+//     static Intermediate parse(std::string_view contents, const std::string &path);
+//
+//     // name to store the asset under
+//     static std::string name(const Intermediate &data);
+template <typename Asset>
+struct AssetLoader;
+
+template <typename Asset>
+concept DirectoryLoadable = requires(std::string_view contents, const std::string &path,
+    const typename AssetLoader<Asset>::Intermediate &data) {
+
+    { AssetLoader<Asset>::parse(contents, path) } -> std::same_as<typename AssetLoader<Asset>::Intermediate>;
+    { AssetLoader<Asset>::name(data) } -> std::convertible_to<std::string>;
+};
+
+enum class AssetState {
+    // never requested, or requested under another name
+    Missing,
+    // being read on a worker thread or waiting to be finalized
+    Loading,
+    Loaded,
+    Failed,
+};
+
+// Progress of an asset requested through `AssetManager::load_async`
+struct AssetLoadStatus {
+    std::string name = {};
+    std::string path = {};
+    std::atomic<AssetState> state = AssetState::Loading;
+    // why loading failed, set before `state` becomes `Failed`
+    std::string error = {};
+
+    AssetState get_state() const noexcept {
+        return state.load(std::memory_order_acquire);
+    }
+
+    bool done() const noexcept {
+        return get_state() == AssetState::Loaded || get_state() == AssetState::Failed;
+    }
+};
+
+using AssetLoad = std::shared_ptr<const AssetLoadStatus>;
+
+// Outcome of `AssetManager::load_directory`
+struct DirectoryLoadResult {
+    struct Error {
+        std::string path = {};
+        std::string message = {};
+    };
+
+    // Wall clock time of each phase. Enumerating and inserting happen on the calling
+    // thread, reading and parsing on the thread pool.
+    struct Timings {
+        std::chrono::nanoseconds enumerate = {};
+        std::chrono::nanoseconds read = {};
+        std::chrono::nanoseconds parse = {};
+        std::chrono::nanoseconds insert = {};
+
+        std::chrono::nanoseconds total() const noexcept {
+            return enumerate + read + parse + insert;
+        }
+    };
+
+    // files found with the requested extension
+    std::size_t files = 0;
+    // assets stored, one per file without an error
+    std::size_t loaded = 0;
+    // one per file that failed, in path order
+    std::vector<Error> errors = {};
+    Timings timings = {};
+
+    bool ok() const noexcept {
+        return errors.empty();
+    }
+};
+
+}
+
+#endif // _CALICO_ASSET_LOADER_HPP_
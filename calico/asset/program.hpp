@@ -15,9 +15,11 @@ struct ProgramDescriptor {
     };
 
     std::string name;
-    std::unordered_map<std::string, std::string> shader_to_source;
+    // shader file, relative to the descriptor, to its stage
     std::unordered_map<std::string, ShaderType> shader_to_type;
+    // uniform name to its GLSL type
     std::unordered_map<std::string, std::string> uniforms;
+    // names of the uniform blocks the program uses
     std::vector<std::string> uniform_buffers;
 };
 
@@ -0,0 +1,127 @@
+// Plays back a frame of recorded component additions and removals over many entities
+// and reports the time per command. Then checks that deleting an entity from one
+// thread's buffer while another thread's buffer adds or removes one of its components
+// plays back without throwing, whichever buffer comes first, and that the other
+// commands of the frame still apply.
+//
+// build with `make bench` and run `bench/command_buffer`
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Entities = 100000;
+constexpr std::size_t Frames = 20;
+
+struct Position {
+    float x, y, z;
+};
+
+struct Velocity {
+    float x, y, z;
+};
+
+// Run `fn` on a worker of `pool`, so it records into a worker's buffer rather than
+// the calling thread's
+template <typename Fn>
+static void on_worker(ThreadPool &pool, Fn &&fn) {
+    std::atomic<bool> done = false;
+    pool.submit_background([&] {
+        fn();
+        done.store(true, std::memory_order_release);
+    });
+
+    while (!done.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+// Whether a delete of one entity in one buffer and `record` on the same entity in
+// another buffer play back cleanly, with the entity deleted and `bystander` given
+// its component
+template <typename Record>
+static bool delete_with_other_buffer(bool delete_on_worker, Record &&record) {
+    ECSManager ecs;
+    ecs.register_component<Position>();
+    ecs.register_component<Velocity>();
+
+    Entity entity = ecs.new_entity();
+    Entity bystander = ecs.new_entity();
+    ecs.add_component_to(entity, Position{ 0.0f, 0.0f, 0.0f });
+
+    auto &pool = ecs.get_thread_pool();
+    auto delete_entity = [&] { ecs.commands().delete_entity(entity); };
+    auto other = [&] {
+        record(ecs.commands(), entity);
+        ecs.commands().add_component_to(bystander, Velocity{ 1.0f, 0.0f, 0.0f });
+    };
+
+    if (delete_on_worker) {
+        on_worker(pool, delete_entity);
+        other();
+    } else {
+        delete_entity();
+        on_worker(pool, other);
+    }
+
+    try {
+        ecs.flush_commands();
+    } catch (const std::exception &e) {
+        std::printf("  playback threw: %s\n", e.what());
+        return false;
+    }
+
+    return !ecs.is_alive(entity) && ecs.has_component<Velocity>(bystander);
+}
+
+int main() {
+    ECSManager ecs;
+    ecs.register_component<Position>();
+    ecs.register_component<Velocity>();
+
+    std::vector<Entity> entities;
+    for (std::size_t i = 0; i < Entities; i++) {
+        entities.push_back(ecs.new_entity());
+        ecs.add_component_to(entities.back(), Position{ 0.0f, 0.0f, 0.0f });
+    }
+
+    double seconds = 0.0;
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        for (Entity entity : entities) {
+            ecs.commands().add_component_to(entity, Velocity{ 1.0f, 0.0f, 0.0f });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ecs.flush_commands();
+
+        for (Entity entity : entities) {
+            ecs.commands().remove_component_from<Velocity>(entity);
+        }
+
+        ecs.flush_commands();
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::printf("%zu entities, %.1f ns/command played back\n", Entities, seconds * 1e9 / (2 * Entities * Frames));
+
+    auto add = [](CommandBuffer &buffer, Entity entity) {
+        buffer.add_component_to(entity, Velocity{ 1.0f, 0.0f, 0.0f });
+    };
+    auto remove = [](CommandBuffer &buffer, Entity entity) {
+        buffer.remove_component_from<Position>(entity);
+    };
+
+    std::size_t failures = 0;
+    for (bool delete_on_worker : { false, true }) {
+        failures += !delete_with_other_buffer(delete_on_worker, add);
+        failures += !delete_with_other_buffer(delete_on_worker, remove);
+    }
+
+    std::printf("deletes racing another buffer's commands that failed: %zu\n", failures);
+    return failures == 0 ? 0 : 1;
+}
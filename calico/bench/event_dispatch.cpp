@@ -0,0 +1,95 @@
+// Compares dispatching an event to member function listeners through the
+// `std::list<std::function>` per `EventType` map `EventManager` used to keep, bound with
+// `std::bind`, against the flat `Delegate` arrays it keeps now, for both `Event`s and
+// typed events.
+//
+// build with `make bench` and run `bench/event_dispatch`
+
+#include <chrono>
+#include <cstdio>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Listeners = 8;
+constexpr std::size_t Broadcasts = 2000000;
+
+struct OldEventManager {
+    std::unordered_map<EventType, std::list<std::function<void(const Event&)>>> event_handlers {};
+
+    void add_listener(const EventType type, std::function<void(const Event&)> &&handler) {
+        event_handlers[type].push_back(handler);
+    }
+
+    void broadcast(const Event &e) const {
+        if (!event_handlers.contains(e.type)) {
+            return;
+        }
+
+        for (const auto &handler : event_handlers.at(e.type)) {
+            handler(e);
+        }
+    }
+};
+
+struct Listener {
+    float total = 0.0f;
+
+    void on_event(const Event &e) {
+        total += e.get_if<MouseMovedEvent>()->x;
+    }
+
+    void on_mouse_moved(const MouseMovedEvent &e) {
+        total += e.x;
+    }
+};
+
+template <typename Fn>
+static double ns_per_broadcast(Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < Broadcasts; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / Broadcasts;
+}
+
+int main() {
+    std::vector<Listener> listeners(Listeners);
+
+    OldEventManager old_manager;
+    EventManager manager;
+    for (auto &listener : listeners) {
+        old_manager.add_listener(EventType::MouseMoved,
+            std::bind(&Listener::on_event, &listener, std::placeholders::_1));
+        manager.add_listener(EventType::MouseMoved, delegate<&Listener::on_event>(&listener));
+        manager.add_listener(delegate<&Listener::on_mouse_moved>(&listener));
+    }
+
+    MouseMovedEvent moved;
+    moved.x = 1.0f;
+    Event event(moved);
+
+    double old_dispatch = ns_per_broadcast([&](std::size_t) {
+        old_manager.broadcast(event);
+    });
+
+    double event_dispatch = ns_per_broadcast([&](std::size_t) {
+        manager.broadcast(event);
+    });
+
+    double typed_dispatch = ns_per_broadcast([&](std::size_t) {
+        manager.broadcast(moved);
+    });
+
+    float checksum = 0.0f;
+    for (const auto &listener : listeners) {
+        checksum += listener.total;
+    }
+
+    std::printf("%zu listeners, checksum %.0f\n", Listeners, checksum);
+    std::printf("list<function> + std::bind    %7.2f ns/broadcast\n", old_dispatch);
+    std::printf("Delegate array, Event         %7.2f ns/broadcast\n", event_dispatch);
+    std::printf("Delegate array, typed event   %7.2f ns/broadcast\n", typed_dispatch);
+}
@@ -0,0 +1,86 @@
+// Measures how long `EventManager::post` takes with several threads posting at once
+// while the main thread drains the queue, reporting percentiles of the latency of a
+// single post and how many events were dropped because the queue was full.
+//
+// build with `make bench` and run `bench/event_ingestion [max producers]`
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Posts_Per_Producer = 200000;
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    return sorted[static_cast<std::size_t>(p * (sorted.size() - 1))];
+}
+
+static void run(std::size_t producers) {
+    EventManager manager;
+    std::size_t received = 0;
+    manager.add_batch_listener<MouseMovedEvent>([&](std::span<const MouseMovedEvent> events) {
+        received += events.size();
+    });
+
+    std::vector<std::vector<double>> latencies(producers);
+    std::atomic<std::size_t> running = producers;
+    std::vector<std::thread> threads;
+
+    for (std::size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            auto &samples = latencies[p];
+            samples.reserve(Posts_Per_Producer);
+
+            for (std::size_t i = 0; i < Posts_Per_Producer; i++) {
+                MouseMovedEvent event;
+                event.x = static_cast<float>(i);
+
+                auto start = std::chrono::steady_clock::now();
+                manager.post(event);
+                auto end = std::chrono::steady_clock::now();
+                samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            }
+
+            running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    while (running.load(std::memory_order_acquire) > 0) {
+        manager.dispatch_queued();
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    manager.dispatch_queued();
+
+    std::vector<double> all;
+    for (const auto &samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+
+    std::sort(all.begin(), all.end());
+
+    QueueStats stats = manager.posted_stats();
+    std::printf("%2zu producers  p50 %7.1f ns  p90 %7.1f ns  p99 %8.1f ns  p99.9 %8.1f ns"
+        "  max %9.1f ns  received %8zu  dropped %8zu  high water %4zu\n",
+        producers, percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99),
+        percentile(all, 0.999), all.back(), received, stats.dropped, stats.high_water);
+}
+
+int main(int argc, char **argv) {
+    std::size_t max_producers = argc > 1
+        ? std::strtoul(argv[1], nullptr, 10)
+        : std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t producers = 1; producers <= max_producers; producers *= 2) {
+        run(producers);
+    }
+}
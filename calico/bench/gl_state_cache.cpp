@@ -0,0 +1,110 @@
+// Runs frames that set per-object uniforms, write a uniform buffer and draw objects
+// sharing a few programs and meshes, against the recording GL stand-in. Reports the
+// GL calls per frame and the binds the `StateCache` issued and avoided, and checks
+// from the recorded bindings that every draw used the program and vertex array it
+// asked for. `-v` prints the call stream of the first frame.
+//
+// build with `make bench` (glm must be in glm/) and run `bench/gl_state_cache [-v]`
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if __has_include("glm/glm.hpp") && __has_include(<GL/glcorearb.h>)
+#define CALICO_BENCH_RENDERER
+#include "renderer/opengl/recording_gl.hpp"
+#include "CalicoOpenGLRenderer.hpp"
+#endif
+
+#ifdef CALICO_BENCH_RENDERER
+
+#include <memory>
+
+using namespace Calico;
+using namespace Calico::OpenGL;
+
+constexpr std::size_t Objects = 5000;
+constexpr std::size_t Programs = 4;
+constexpr std::size_t Meshes = 32;
+constexpr std::size_t Frames = 50;
+
+int main(int argc, char **argv) {
+    bool verbose = argc > 1 && std::strcmp(argv[1], "-v") == 0;
+
+    std::vector<std::unique_ptr<Program>> programs;
+    for (std::size_t i = 0; i < Programs; i++) {
+        programs.push_back(std::make_unique<Program>());
+    }
+
+    std::vector<std::unique_ptr<VertexArray<glm::vec3>>> meshes;
+    for (std::size_t i = 0; i < Meshes; i++) {
+        meshes.push_back(std::make_unique<VertexArray<glm::vec3>>());
+        meshes.back()->set_indices({ 0, 1, 2 });
+    }
+
+    UniformBlock<glm::mat4, float> globals("Globals");
+
+    auto &gl = GLRecorder::get();
+    auto &cache = StateCache::get();
+    gl.clear();
+    cache.end_frame();
+
+    std::size_t wrong_state = 0;
+    StateCacheStats totals = {};
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        gl.record_calls = verbose && frame == 0;
+
+        globals.set<0>(glm::mat4{});
+        globals.set<1>(static_cast<float>(frame));
+        globals.flush();
+
+        // objects grouped by program, as a sorted render queue would submit them
+        for (std::size_t i = 0; i < Objects; i++) {
+            auto &program = *programs[i * Programs / Objects];
+            auto &mesh = *meshes[i % Meshes];
+
+            program.set_uniform_mat4("model", glm::mat4{});
+            program.set_uniform_float("scale", 1.0f);
+            mesh.draw(program);
+
+            if (gl.bound_program() != static_cast<program_t>(program) || gl.bound_vertex_array() != mesh.get_id()) {
+                wrong_state++;
+            }
+        }
+
+        auto stats = cache.end_frame();
+        totals.programs.issued += stats.programs.issued;
+        totals.programs.avoided += stats.programs.avoided;
+        totals.vertex_arrays.issued += stats.vertex_arrays.issued;
+        totals.vertex_arrays.avoided += stats.vertex_arrays.avoided;
+        totals.buffers.issued += stats.buffers.issued;
+        totals.buffers.avoided += stats.buffers.avoided;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (verbose) {
+        gl.print();
+    }
+
+    std::printf("%zu objects, %zu programs, %zu meshes, per frame:\n", Objects, Programs, Meshes);
+    std::printf("  %zu GL calls, %zu glUseProgram, %zu glBindVertexArray, %zu glBindBuffer\n",
+        gl.total() / Frames, gl.count("glUseProgram") / Frames, gl.count("glBindVertexArray") / Frames,
+        gl.count("glBindBuffer") / Frames);
+    std::printf("  programs:      %7zu bound %7zu avoided\n", totals.programs.issued / Frames, totals.programs.avoided / Frames);
+    std::printf("  vertex arrays: %7zu bound %7zu avoided\n", totals.vertex_arrays.issued / Frames, totals.vertex_arrays.avoided / Frames);
+    std::printf("  buffers:       %7zu bound %7zu avoided\n", totals.buffers.issued / Frames, totals.buffers.avoided / Frames);
+    std::printf("  %.1f ns/object\n", seconds * 1e9 / (Objects * Frames));
+    std::printf("draws with the wrong state bound: %zu\n", wrong_state);
+
+    return wrong_state == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::printf("gl_state_cache needs glm in glm/ and GL/glcorearb.h\n");
+}
+
+#endif
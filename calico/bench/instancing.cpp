@@ -0,0 +1,101 @@
+// Draws entities sharing a few meshes and programs, once by setting a "model" uniform
+// and calling `draw` for each entity and once by gathering their transforms with an
+// `InstanceBatcher`, against the recording GL stand-in. Reports the GL calls, draws
+// and uniform uploads per frame each way, and the time taken per entity.
+//
+// build with `make bench` (glm must be in glm/) and run `bench/instancing [entities]`
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#if __has_include("glm/glm.hpp") && __has_include(<GL/glcorearb.h>)
+#define CALICO_BENCH_RENDERER
+#include "renderer/opengl/recording_gl.hpp"
+#include "CalicoOpenGLRenderer.hpp"
+#include "Calico.hpp"
+#endif
+
+#ifdef CALICO_BENCH_RENDERER
+
+using namespace Calico;
+using namespace Calico::OpenGL;
+
+constexpr std::size_t Programs = 2;
+constexpr std::size_t Meshes = 8;
+constexpr std::size_t Frames = 50;
+
+struct Transform {
+    glm::mat4 model;
+};
+
+static void report(const char *label, std::size_t entities, double seconds) {
+    auto &gl = GLRecorder::get();
+    std::size_t draws = gl.count("glDrawElements") + gl.count("glDrawElementsInstanced");
+    std::printf("%-10s %8zu GL calls  %7zu draws  %7zu glUniformMatrix4fv  %7.1f ns/entity\n",
+        label, gl.total() / Frames, draws / Frames, gl.count("glUniformMatrix4fv") / Frames,
+        seconds * 1e9 / (entities * Frames));
+}
+
+int main(int argc, char **argv) {
+    std::size_t entities = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+
+    std::vector<std::unique_ptr<Program>> programs;
+    for (std::size_t i = 0; i < Programs; i++) {
+        programs.push_back(std::make_unique<Program>());
+    }
+
+    std::vector<std::unique_ptr<VertexArray<glm::vec3>>> meshes;
+    for (std::size_t i = 0; i < Meshes; i++) {
+        meshes.push_back(std::make_unique<VertexArray<glm::vec3>>());
+        meshes.back()->set_indices({ 0, 1, 2 });
+        meshes.back()->set_instance_layout<glm::mat4>();
+    }
+
+    ECSManager ecs;
+    ecs.register_component<Transform>();
+    ecs.register_component<InstancedMesh>();
+
+    for (std::size_t i = 0; i < entities; i++) {
+        Entity entity = ecs.new_entity();
+        auto offset = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+        ecs.add_component_to<Transform>(entity, Transform{ glm::translate(glm::mat4(1.0f), offset) });
+        ecs.add_component_to<InstancedMesh>(entity, InstancedMesh{ meshes[i % Meshes].get(), programs[i % Programs].get() });
+    }
+
+    auto &gl = GLRecorder::get();
+    gl.record_calls = false;
+    std::printf("%zu entities, %zu programs, %zu meshes\n", entities, Programs, Meshes);
+
+    gl.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        ecs.for_each<InstancedMesh, Transform>([](Entity, InstancedMesh &instanced, Transform &transform) {
+            instanced.program->set_uniform_mat4("model", transform.model);
+            instanced.mesh->draw(*instanced.program);
+        });
+    }
+    report("per draw", entities, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    InstanceBatcher<glm::mat4> batcher;
+    gl.clear();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        batcher.gather<Transform>(ecs, [](const Transform &transform) { return transform.model; });
+        batcher.draw();
+    }
+    report("instanced", entities, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    const auto &stats = batcher.get_stats();
+    std::printf("instanced: %zu draws of %zu instances\n", stats.draws, stats.instances);
+
+    return stats.instances == entities ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::printf("instancing needs glm in glm/ and GL/glcorearb.h\n");
+}
+
+#endif
@@ -0,0 +1,94 @@
+// Measures how `ECSManager::parallel_for_each` scales with the number of threads on a
+// transform integration workload, for both storage modes.
+//
+// build with `make bench` and run `bench/parallel_scaling [max threads]`
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Entities = 65000;
+constexpr std::size_t Frames = 50;
+constexpr float Dt = 1.f / 60.f;
+
+struct Transform {
+    float position[3];
+    float rotation[3];
+    float model[16];
+};
+
+struct Velocity {
+    float linear[3];
+    float angular[3];
+};
+
+static void integrate(Transform &transform, const Velocity &velocity) {
+    for (int i = 0; i < 3; i++) {
+        transform.position[i] += velocity.linear[i] * Dt;
+        transform.rotation[i] += velocity.angular[i] * Dt;
+    }
+
+    // rotation about z followed by translation, column major
+    float c = std::cos(transform.rotation[2]);
+    float s = std::sin(transform.rotation[2]);
+    float *m = transform.model;
+    m[0] = c;  m[4] = -s; m[8] = 0.f;  m[12] = transform.position[0];
+    m[1] = s;  m[5] = c;  m[9] = 0.f;  m[13] = transform.position[1];
+    m[2] = 0.f; m[6] = 0.f; m[10] = 1.f; m[14] = transform.position[2];
+    m[3] = 0.f; m[7] = 0.f; m[11] = 0.f; m[15] = 1.f;
+}
+
+static void run(Storage storage, const char *name, std::size_t max_threads) {
+    ECSManager ecs(storage);
+    ecs.register_component<Transform>();
+    ecs.register_component<Velocity>();
+
+    for (std::size_t i = 0; i < Entities; i++) {
+        Entity entity = ecs.new_entity();
+        ecs.add_component_to<Transform>(entity, Transform{});
+        ecs.add_component_to<Velocity>(entity, Velocity{
+            { 1.f, 0.5f, 0.f }, { 0.f, 0.f, static_cast<float>(i % 7) } });
+    }
+
+    double single_thread = 0.0;
+    for (std::size_t threads = 1; threads <= max_threads; threads++) {
+        ThreadPool pool(threads - 1);
+        PerThread<std::size_t> visited(pool);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t frame = 0; frame < Frames; frame++) {
+            ecs.parallel_for_each<Transform, Velocity>(pool,
+                [&visited](Entity, Transform &transform, const Velocity &velocity) {
+                    integrate(transform, velocity);
+                    visited.local()++;
+                });
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::size_t total = 0;
+        visited.for_each([&total](std::size_t count) { total += count; });
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count() / Frames;
+        if (threads == 1) {
+            single_thread = ms;
+        }
+
+        std::printf("%-10s %2zu threads  %8.3f ms/frame  speedup %5.2fx  (%zu visits)\n",
+            name, threads, ms, single_thread / ms, total);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (argc > 1) {
+        max_threads = std::strtoul(argv[1], nullptr, 10);
+    }
+
+    run(Storage::Sparse, "sparse", max_threads);
+    run(Storage::Archetype, "archetype", max_threads);
+}
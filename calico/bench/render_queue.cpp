@@ -0,0 +1,157 @@
+// Draws a frame of objects spread over a few programs, materials and meshes in random
+// order, once by calling `IVertexArray::draw` for each object and once through a
+// `RenderQueue`, against the recording GL stand-in. Reports the GL calls and state
+// changes each way, and the time taken per object. A last queued frame is recorded
+// call by call to check that every draw had the program and vertex array of the
+// packet the sorted queue should draw at that point.
+//
+// build with `make bench` (glm must be in glm/) and run `bench/render_queue [objects]`
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#if __has_include("glm/glm.hpp") && __has_include(<GL/glcorearb.h>)
+#define CALICO_BENCH_RENDERER
+#include "renderer/opengl/recording_gl.hpp"
+#include "CalicoOpenGLRenderer.hpp"
+#endif
+
+#ifdef CALICO_BENCH_RENDERER
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+
+using namespace Calico;
+using namespace Calico::OpenGL;
+
+constexpr std::size_t Programs = 16;
+constexpr std::size_t Materials = 64;
+constexpr std::size_t Meshes = 256;
+constexpr std::size_t Frames = 50;
+
+struct Object {
+    std::size_t program;
+    std::uint16_t material;
+    std::size_t mesh;
+    float depth;
+};
+
+static void report(const char *label, std::size_t objects, double seconds) {
+    auto &gl = GLRecorder::get();
+    std::printf("%-10s %8zu GL calls  %7zu glUseProgram  %7zu glBindVertexArray  %7.1f ns/object\n",
+        label, gl.total() / Frames, gl.count("glUseProgram") / Frames, gl.count("glBindVertexArray") / Frames,
+        seconds * 1e9 / (objects * Frames));
+}
+
+int main(int argc, char **argv) {
+    std::size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+
+    std::vector<std::unique_ptr<Program>> programs;
+    for (std::size_t i = 0; i < Programs; i++) {
+        programs.push_back(std::make_unique<Program>());
+    }
+
+    std::vector<std::unique_ptr<VertexArray<glm::vec3>>> meshes;
+    for (std::size_t i = 0; i < Meshes; i++) {
+        meshes.push_back(std::make_unique<VertexArray<glm::vec3>>());
+        meshes.back()->set_indices({ 0, 1, 2 });
+    }
+
+    // meshes mostly stay with one program, as they would with real materials
+    std::mt19937 random(42);
+    std::vector<Object> scene(objects);
+    for (auto &object : scene) {
+        object.mesh = random() % Meshes;
+        object.program = (object.mesh + random() % 2) % Programs;
+        object.material = static_cast<std::uint16_t>(random() % Materials);
+        object.depth = std::uniform_real_distribution<float>(0.0f, 1.0f)(random);
+    }
+
+    auto &gl = GLRecorder::get();
+    gl.record_calls = false;
+    std::printf("%zu objects, %zu programs, %zu materials, %zu meshes\n", objects, Programs, Materials, Meshes);
+
+    gl.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        for (const auto &object : scene) {
+            meshes[object.mesh]->draw(*programs[object.program]);
+        }
+    }
+    report("immediate", objects, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    RenderQueue queue;
+    gl.clear();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        for (const auto &object : scene) {
+            queue.push(*programs[object.program], *meshes[object.mesh], object.material, object.depth);
+        }
+
+        queue.submit();
+    }
+    report("queue", objects, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    const auto &stats = queue.get_stats();
+    std::printf("queue: %zu draws, %zu material switches, %zu binds elided\n",
+        stats.draws, stats.material_binds, stats.elided_binds());
+
+    // the queue should draw the objects stably sorted by key
+    auto key_of = [&](std::size_t i) {
+        const auto &object = scene[i];
+        return DrawKey::make(static_cast<program_t>(*programs[object.program]), object.material,
+            meshes[object.mesh]->get_id(), object.depth);
+    };
+
+    std::vector<std::size_t> expected(objects);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&](std::size_t lhs, std::size_t rhs) {
+        return key_of(lhs) < key_of(rhs);
+    });
+
+    for (const auto &object : scene) {
+        queue.push(*programs[object.program], *meshes[object.mesh], object.material, object.depth);
+    }
+
+    // binds elided at the start of the frame rely on what the last frame left bound
+    GLuint program = gl.bound_program();
+    GLuint vertex_array = gl.bound_vertex_array();
+    gl.clear();
+    gl.record_calls = true;
+    queue.submit();
+
+    std::size_t draws = 0;
+    std::size_t wrong_state = 0;
+    for (const auto &call : gl.get_calls()) {
+        if (call.function == "glUseProgram") {
+            program = static_cast<GLuint>(call.args[0]);
+        } else if (call.function == "glBindVertexArray") {
+            vertex_array = static_cast<GLuint>(call.args[0]);
+        } else if (call.function == "glDrawElements") {
+            if (draws >= objects) {
+                wrong_state++;
+                continue;
+            }
+
+            const auto &object = scene[expected[draws++]];
+            if (program != static_cast<program_t>(*programs[object.program]) || vertex_array != meshes[object.mesh]->get_id()) {
+                wrong_state++;
+            }
+        }
+    }
+
+    std::printf("draws with the wrong state bound: %zu, missing draws: %zu\n", wrong_state, objects - draws);
+
+    return wrong_state == 0 && draws == objects ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::printf("render_queue needs glm in glm/ and GL/glcorearb.h\n");
+}
+
+#endif
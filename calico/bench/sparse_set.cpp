@@ -0,0 +1,101 @@
+// Compares entity -> component index resolution through the pair of hash maps
+// `ComponentArray` used to keep against the paged `SparseSet`.
+//
+// build with `make bench` and run `bench/sparse_set`
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Entities = 50000;
+constexpr std::size_t Lookup_Rounds = 100;
+
+struct HashIndex {
+    std::unordered_map<Entity, Index> entity_to_component;
+    std::unordered_map<Index, Entity> component_to_entity;
+    std::size_t current_index = 0;
+
+    void insert(Entity entity) {
+        entity_to_component.insert({ entity, current_index });
+        component_to_entity.insert({ current_index, entity });
+        current_index++;
+    }
+
+    Index index_of(Entity entity) {
+        return entity_to_component[entity];
+    }
+
+    void erase(Entity entity) {
+        Index index = entity_to_component[entity];
+        Index last = current_index - 1;
+        Entity last_entity = component_to_entity[last];
+
+        entity_to_component[last_entity] = index;
+        component_to_entity[index] = last_entity;
+        entity_to_component.erase(entity);
+        component_to_entity.erase(last);
+        current_index--;
+    }
+};
+
+struct SparseIndex {
+    SparseSet<> set;
+
+    void insert(Entity entity) { set.insert(entity); }
+    Index index_of(Entity entity) { return set.index_of(entity); }
+    void erase(Entity entity) { set.erase(entity); }
+};
+
+template <typename Fn>
+static double time_ms(Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Storage>
+static void run(const char *name, const std::vector<Entity> &order) {
+    Storage storage;
+    std::size_t checksum = 0;
+
+    double insert = time_ms([&] {
+        for (Entity e : order) {
+            storage.insert(e);
+        }
+    });
+
+    double lookup = time_ms([&] {
+        for (std::size_t round = 0; round < Lookup_Rounds; round++) {
+            for (Entity e : order) {
+                checksum += storage.index_of(e);
+            }
+        }
+    });
+
+    double erase = time_ms([&] {
+        for (std::size_t i = 0; i < order.size(); i += 2) {
+            storage.erase(order[i]);
+        }
+    });
+
+    std::printf("%-12s insert %8.3f ms  lookup %8.2f ns/op  erase %8.3f ms  (checksum %zu)\n",
+        name, insert, lookup * 1e6 / (Lookup_Rounds * order.size()), erase, checksum);
+}
+
+int main() {
+    std::vector<Entity> order;
+    for (std::uint32_t i = 0; i < Entities; i++) {
+        order.emplace_back(i, 0);
+    }
+
+    std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+    run<HashIndex>("unordered_map", order);
+    run<SparseIndex>("sparse set", order);
+}
@@ -0,0 +1,120 @@
+// Streams a frame's dynamic data, a uniform block, the instances of a few meshes and
+// a mesh whose geometry changes every frame, once through the buffers' own uploads and
+// once through a `StreamBuffer`, against the recording GL stand-in. Reports the GL
+// calls and the `glBufferData`/`glBufferSubData` copies per frame each way, and checks
+// that every uniform range bound from the stream is aligned. The stream runs once
+// persistently mapped, as with GL 4.4, and once mapping each write, as with GL 4.1.
+//
+// build with `make bench` (glm must be in glm/) and run `bench/stream_buffer [instances]`
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#if __has_include("glm/glm.hpp") && __has_include(<GL/glcorearb.h>)
+#define CALICO_BENCH_RENDERER
+#include "renderer/opengl/recording_gl.hpp"
+#include "CalicoOpenGLRenderer.hpp"
+#endif
+
+#ifdef CALICO_BENCH_RENDERER
+
+using namespace Calico;
+using namespace Calico::OpenGL;
+
+constexpr std::size_t Meshes = 8;
+constexpr std::size_t Dynamic_Vertices = 1000;
+constexpr std::size_t Frames = 50;
+
+static void report(const char *label, double seconds) {
+    auto &gl = GLRecorder::get();
+    std::printf("%-8s %7zu GL calls  %6zu glBufferData  %6zu glBufferSubData  %6zu glBindBufferRange  %8.1f us/frame\n",
+        label, gl.total() / Frames, gl.count("glBufferData") / Frames, gl.count("glBufferSubData") / Frames,
+        gl.count("glBindBufferRange") / Frames, seconds * 1e6 / Frames);
+}
+
+int main(int argc, char **argv) {
+    std::size_t instances = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+
+    Program program;
+    std::vector<std::unique_ptr<VertexArray<glm::vec3>>> meshes;
+    for (std::size_t i = 0; i < Meshes; i++) {
+        meshes.push_back(std::make_unique<VertexArray<glm::vec3>>());
+        meshes.back()->set_indices({ 0, 1, 2 });
+        meshes.back()->set_instance_layout<glm::mat4>();
+    }
+
+    VertexArray<glm::vec3> dynamic;
+    dynamic.set_indices({ 0, 1, 2 });
+    std::vector<float> positions(Dynamic_Vertices * 3, 0.0f);
+
+    UniformBlock<glm::mat4, float> globals("Globals");
+
+    std::size_t per_frame = globals.get_size() + instances * sizeof(glm::mat4) + positions.size() * sizeof(float);
+    InstanceBatcher<glm::mat4> batcher;
+
+    auto &gl = GLRecorder::get();
+    gl.record_calls = false;
+    std::printf("%zu instances over %zu meshes, %zu dynamic vertices, %zu bytes per frame\n",
+        instances, Meshes, Dynamic_Vertices, per_frame);
+
+    auto add_instances = [&] {
+        for (std::size_t i = 0; i < instances; i++) {
+            batcher.add(*meshes[i % Meshes], program, 0, glm::mat4(1.0f));
+        }
+    };
+
+    gl.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        globals.set<0>(glm::mat4(1.0f));
+        globals.set<1>(static_cast<float>(frame));
+        globals.flush();
+        dynamic.set_data(positions);
+        dynamic.draw(program);
+        add_instances();
+        batcher.draw();
+    }
+    report("upload", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    std::size_t misaligned = 0;
+    for (int version : { 46, 41 }) {
+        gl.gl_version = version;
+        StreamBuffer stream(per_frame + 64 * 1024);
+
+        gl.clear();
+        start = std::chrono::steady_clock::now();
+        for (std::size_t frame = 0; frame < Frames; frame++) {
+            gl.record_calls = frame == 0;
+
+            globals.set<0>(glm::mat4(1.0f));
+            globals.set<1>(static_cast<float>(frame));
+            globals.flush(stream);
+            dynamic.set_data(stream, positions);
+            dynamic.draw(program);
+            add_instances();
+            batcher.draw(stream);
+            stream.end_frame();
+        }
+        report(stream.is_persistent() ? "stream" : "mapped", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        for (const auto &call : gl.get_calls()) {
+            if (call.function == "glBindBufferRange" && call.args[3] % 256 != 0) {
+                misaligned++;
+            }
+        }
+
+        std::printf("  %zu byte regions, %zu stalls\n", stream.get_region_size(), stream.get_stalls());
+    }
+
+    std::printf("misaligned uniform ranges: %zu\n", misaligned);
+    return misaligned == 0 ? 0 : 1;
+}
+
+#else
+
+int main() {
+    std::printf("stream_buffer needs glm in glm/ and GL/glcorearb.h\n");
+}
+
+#endif
@@ -0,0 +1,76 @@
+// Measures the cost of resolving a component type to its storage: the
+// `typeid(C).name()` keyed map `ComponentManager` used to look storage up in on every
+// call, against the `TypeFamily` ids it uses now, along with the total cost of an
+// `ECSManager::get_component` call.
+//
+// build with `make bench` and run `bench/type_lookup`
+
+#include <chrono>
+#include <cstdio>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Calls = 10000000;
+
+template <std::size_t N>
+struct Component {
+    float value[4];
+};
+
+struct BenchFamily {};
+
+template <typename Fn>
+static double ns_per_call(Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < Calls; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / Calls;
+}
+
+// keep the optimizer from discarding a result
+template <typename T>
+static void consume(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+int main() {
+    // the old lookup, with a few other types registered as a real scene would have
+    std::unordered_map<const char*, std::unique_ptr<IComponentArray>> by_name;
+    by_name[typeid(Component<0>).name()] = nullptr;
+    by_name[typeid(Component<1>).name()] = nullptr;
+    by_name[typeid(Component<2>).name()] = nullptr;
+    by_name[typeid(Component<3>).name()] = nullptr;
+
+    std::array<std::unique_ptr<IComponentArray>, Max_Components> by_id = {};
+
+    double name_lookup = ns_per_call([&](std::size_t) {
+        consume(by_name[typeid(Component<2>).name()]);
+    });
+
+    double family_lookup = ns_per_call([&](std::size_t) {
+        consume(by_id[TypeFamily<BenchFamily>::id<Component<2>>()]);
+    });
+
+    ECSManager ecs;
+    ecs.register_component<Component<0>>();
+    ecs.register_component<Component<1>>();
+    ecs.register_component<Component<2>>();
+
+    std::vector<Entity> entities;
+    for (std::size_t i = 0; i < 1024; i++) {
+        entities.push_back(ecs.new_entity());
+        ecs.add_component_to<Component<2>>(entities.back(), Component<2>{});
+    }
+
+    double get_component = ns_per_call([&](std::size_t i) {
+        consume(ecs.get_component<Component<2>>(entities[i % entities.size()]));
+    });
+
+    std::printf("typeid(C).name() map lookup  %6.2f ns/call\n", name_lookup);
+    std::printf("TypeFamily id lookup         %6.2f ns/call\n", family_lookup);
+    std::printf("ECSManager::get_component    %6.2f ns/call\n", get_component);
+}
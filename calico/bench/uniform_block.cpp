@@ -0,0 +1,110 @@
+// Updates the members of a few uniform blocks every frame, once uploading each member
+// as it is set, as `UniformBuffer::set_data` used to, and once writing the CPU copy and
+// flushing each block once, against the recording GL stand-in. Reports the uploads and
+// bytes per frame each way. The std140 and std430 offsets of a block mixing every
+// supported member type are checked at compile time against the GLSL rules.
+//
+// build with `make bench` (glm must be in glm/) and run `bench/uniform_block`
+
+#include <chrono>
+#include <cstdio>
+
+#if __has_include("glm/glm.hpp") && __has_include(<GL/glcorearb.h>)
+#define CALICO_BENCH_RENDERER
+#include "renderer/opengl/recording_gl.hpp"
+#include "CalicoOpenGLRenderer.hpp"
+#endif
+
+#ifdef CALICO_BENCH_RENDERER
+
+using namespace Calico;
+using namespace Calico::OpenGL;
+
+// layout(std140) uniform Example { float a; vec2 b; vec3 c; float d; mat3 e; float f[2]; vec4 g; bool h; };
+using Example140 = Std140<float, glm::vec2, glm::vec3, float, glm::mat3, std::array<float, 2>, glm::vec4, bool>;
+static_assert(Example140::offsets == std::array<std::size_t, 8>{ 0, 8, 16, 28, 32, 80, 112, 128 });
+static_assert(Example140::size == 144);
+
+using Example430 = Std430<float, glm::vec2, glm::vec3, float, glm::mat3, std::array<float, 2>, glm::vec4, bool>;
+static_assert(Example430::offsets == std::array<std::size_t, 8>{ 0, 8, 16, 28, 32, 80, 96, 112 });
+static_assert(Example430::size == 128);
+
+constexpr std::size_t Blocks = 16;
+constexpr std::size_t Frames = 1000;
+
+using Lights = UniformBlock<glm::vec4, glm::vec4, glm::vec3, float, glm::vec3, float, glm::mat4>;
+
+static void set_members(Lights &block, float value) {
+    block.set<0>(glm::vec4{ value, value, value, 1.0f });
+    block.set<1>(glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+    block.set<2>(glm::vec3{ 0.0f, value, 0.0f });
+    block.set<3>(value);
+    block.set<4>(glm::vec3{ value, 0.0f, 0.0f });
+    block.set<5>(2.0f * value);
+    block.set<6>(glm::mat4(value));
+}
+
+static void report(const char *label, double seconds) {
+    auto &gl = GLRecorder::get();
+    std::size_t bytes = 0;
+    for (const auto &call : gl.get_calls()) {
+        if (call.function == "glBufferSubData") {
+            bytes += static_cast<std::size_t>(call.args[2]);
+        }
+    }
+
+    std::printf("%-14s %6zu glBufferSubData %8zu bytes per frame  %7.1f ns/block\n", label,
+        gl.count("glBufferSubData") / Frames, bytes / Frames, seconds * 1e9 / (Blocks * Frames));
+}
+
+int main() {
+    std::vector<std::unique_ptr<Lights>> blocks;
+    for (std::size_t i = 0; i < Blocks; i++) {
+        blocks.push_back(std::make_unique<Lights>("Lights"));
+        blocks.back()->flush();
+    }
+
+    auto &gl = GLRecorder::get();
+    std::printf("%zu blocks of %zu bytes, 7 members each\n", Blocks, blocks[0]->get_size());
+
+    gl.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        for (auto &block : blocks) {
+            // flushing after every member uploads each on its own
+            block->set<0>(glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+            block->flush();
+            block->set<1>(glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+            block->flush();
+            block->set<2>(glm::vec3{ 0.0f, 1.0f, 0.0f });
+            block->flush();
+            block->set<3>(1.0f);
+            block->flush();
+            block->set<4>(glm::vec3{ 1.0f, 0.0f, 0.0f });
+            block->flush();
+            block->set<5>(2.0f);
+            block->flush();
+            block->set<6>(glm::mat4(1.0f));
+            block->flush();
+        }
+    }
+    report("per member", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    gl.clear();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < Frames; frame++) {
+        for (auto &block : blocks) {
+            set_members(*block, static_cast<float>(frame));
+            block->flush();
+        }
+    }
+    report("flushed", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+#else
+
+int main() {
+    std::printf("uniform_block needs glm in glm/ and GL/glcorearb.h\n");
+}
+
+#endif
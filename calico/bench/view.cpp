@@ -0,0 +1,87 @@
+// Compares integrating positions by looping over a system-style `std::set<Entity>`
+// and calling `ECSManager::get_component` per entity against `ECSManager::view`.
+//
+// build with `make bench` and run `bench/view`
+
+#include <chrono>
+#include <cstdio>
+
+#include "Calico.hpp"
+
+using namespace Calico;
+
+constexpr std::size_t Entities = 60000;
+constexpr std::size_t Frames = 100;
+
+struct Position {
+    float x, y, z;
+};
+
+struct Velocity {
+    float x, y, z;
+};
+
+template <typename Fn>
+static double time_ms(Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    ECSManager ecs;
+    ecs.register_component<Position>();
+    ecs.register_component<Velocity>();
+
+    // what `SystemManager` would hand a system requiring both components
+    std::set<Entity> moving;
+
+    for (std::size_t i = 0; i < Entities; i++) {
+        Entity entity = ecs.new_entity();
+        ecs.add_component_to<Position>(entity, Position{ 0.f, 0.f, 0.f });
+
+        if (i % 4 != 0) {
+            ecs.add_component_to<Velocity>(entity, Velocity{ 1.f, 2.f, 3.f });
+            moving.insert(entity);
+        }
+    }
+
+    double get_component = time_ms([&] {
+        for (std::size_t frame = 0; frame < Frames; frame++) {
+            for (Entity entity : moving) {
+                auto &position = ecs.get_component<Position>(entity);
+                const auto &velocity = ecs.get_component<Velocity>(entity);
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            }
+        }
+    });
+
+    double view = time_ms([&] {
+        for (std::size_t frame = 0; frame < Frames; frame++) {
+            for (auto [entity, position, velocity] : ecs.view<Position, Velocity>()) {
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            }
+        }
+    });
+
+    double each = time_ms([&] {
+        for (std::size_t frame = 0; frame < Frames; frame++) {
+            ecs.view<Position, Velocity>().each([](Entity, Position &position, const Velocity &velocity) {
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            });
+        }
+    });
+
+    double per_entity = 1e6 / static_cast<double>(Frames * moving.size());
+    std::printf("get_component loop %8.2f ns/entity\n", get_component * per_entity);
+    std::printf("view iterator      %8.2f ns/entity\n", view * per_entity);
+    std::printf("view each          %8.2f ns/entity\n", each * per_entity);
+    std::printf("checksum %f\n", ecs.get_component<Position>(*moving.begin()).x);
+}
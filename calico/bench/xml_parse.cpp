@@ -0,0 +1,139 @@
+// Measures descriptor parsing throughput in MB/s: the raw `PullParser` token stream,
+// and the full `XML::parse_material` / `XML::parse_program` paths built on it. When
+// TinyXML is checked out under thirdparty/tinyxml, the DOM parse the descriptors used
+// to go through is measured on the same documents for comparison.
+//
+// build with `make bench` and run `bench/xml_parse`
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "xml/parsers.hpp"
+#include "xml/pull_parser.hpp"
+
+#if __has_include("thirdparty/tinyxml/tinyxml.h")
+#define CALICO_BENCH_TINYXML
+#include "thirdparty/tinyxml/tinyxml.h"
+#if __has_include("thirdparty/tinyxml/tinystr.cpp")
+#include "thirdparty/tinyxml/tinystr.cpp"
+#endif
+#include "thirdparty/tinyxml/tinyxml.cpp"
+#include "thirdparty/tinyxml/tinyxmlerror.cpp"
+#include "thirdparty/tinyxml/tinyxmlparser.cpp"
+#endif
+
+using namespace Calico;
+
+constexpr std::size_t Properties = 4000;
+constexpr std::size_t Uniforms = 4000;
+constexpr double Target_Bytes = 256.0 * 1024 * 1024;
+
+static std::string make_material() {
+    std::string document = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<material name=\"bench_mat\">\n"
+        "    <shader name=\"default_shader\"/>\n    <properties>\n";
+
+    for (std::size_t i = 0; i < Properties; i++) {
+        std::string name = "property_" + std::to_string(i);
+        switch (i % 3) {
+        case 0:
+            document += "        <property name=\"" + name + "\" type=\"vec3\">0.25, 1.5, -3.125</property>\n";
+            break;
+        case 1:
+            document += "        <property name=\"" + name + "\" type=\"float\">32.0</property>\n";
+            break;
+        default:
+            document += "        <property name=\"" + name + "\" type=\"mat4\">"
+                "1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0</property>\n";
+            break;
+        }
+    }
+
+    return document + "    </properties>\n</material>\n";
+}
+
+static std::string make_program() {
+    std::string document = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<program name=\"bench_program\" version=\"410 core\">\n    <shaders>\n"
+        "        <shader type=\"vertex\" version=\"410 core\">shaders/default.vert</shader>\n"
+        "        <shader type=\"fragment\" version=\"410 core\">shaders/default.frag</shader>\n"
+        "    </shaders>\n    <layout>\n        <location attrib=\"0\" type=\"vec3\"/>\n    </layout>\n"
+        "    <uniform-buffers>\n        <buffer>Globals</buffer>\n    </uniform-buffers>\n    <uniforms>\n";
+
+    for (std::size_t i = 0; i < Uniforms; i++) {
+        document += "        <uniform type=\"mat4\">uniform_" + std::to_string(i) + "</uniform>\n";
+    }
+
+    return document + "    </uniforms>\n</program>\n";
+}
+
+template <typename F>
+static void measure(const char *label, const std::string &document, F &&parse) {
+    std::size_t iterations = static_cast<std::size_t>(Target_Bytes / document.size()) + 1;
+    std::size_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; i++) {
+        checksum += parse(document);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = static_cast<double>(document.size()) * iterations / (1024.0 * 1024.0);
+    std::printf("  %-28s %9.1f MB/s  (checksum %zu)\n", label, megabytes / seconds, checksum);
+}
+
+static std::size_t count_tokens(const std::string &document) {
+    XML::PullParser parser(document);
+    std::size_t tokens = 0;
+    while (parser.next() != XML::PullParser::Token::End) {
+        tokens++;
+    }
+
+    return tokens;
+}
+
+#ifdef CALICO_BENCH_TINYXML
+static std::size_t count_nodes(const TiXmlNode *node) {
+    std::size_t nodes = 1;
+    for (const TiXmlNode *child = node->FirstChild(); child; child = child->NextSibling()) {
+        nodes += count_nodes(child);
+    }
+
+    return nodes;
+}
+
+static std::size_t tinyxml_parse(const std::string &document) {
+    TiXmlDocument dom;
+    dom.Parse(document.c_str());
+    return count_nodes(&dom);
+}
+#endif
+
+int main() {
+    struct Document {
+        const char *name;
+        std::string contents;
+        std::size_t (*parse)(const std::string&);
+    };
+
+    Document documents[] = {
+        { "material", make_material(), [](const std::string &document) {
+            return XML::parse_material(document, "bench").properties.size();
+        } },
+        { "program", make_program(), [](const std::string &document) {
+            return XML::parse_program(document, "bench").uniforms.size();
+        } },
+    };
+
+    for (const auto &document : documents) {
+        std::printf("%s descriptor, %.1f KB\n", document.name, document.contents.size() / 1024.0);
+        measure("pull parser tokens", document.contents, count_tokens);
+        measure("pull parser descriptor", document.contents, document.parse);
+#ifdef CALICO_BENCH_TINYXML
+        measure("TinyXML DOM", document.contents, tinyxml_parse);
+#else
+        std::printf("  %-28s not found in thirdparty/tinyxml\n", "TinyXML DOM");
+#endif
+    }
+}
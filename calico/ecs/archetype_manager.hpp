@@ -0,0 +1,437 @@
+#ifndef _CALICO_ARCHETYPE_MANAGER_HPP_
+#define _CALICO_ARCHETYPE_MANAGER_HPP_
+
+namespace Calico {
+
+// Type-erased description of a component, letting archetype chunks move and destroy
+// components without knowing their type
+struct ComponentInfo {
+    const char *name = nullptr;
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+    void (*move_construct)(void *dst, void *src) = nullptr;
+    void (*destroy)(void *ptr) = nullptr;
+
+    template <typename C>
+    static ComponentInfo of() {
+        return {
+            .name = typeid(C).name(),
+            .size = sizeof(C),
+            .alignment = alignof(C),
+            .move_construct = [](void *dst, void *src) {
+                new (dst) C(std::move(*static_cast<C*>(src)));
+            },
+            .destroy = [](void *ptr) {
+                static_cast<C*>(ptr)->~C();
+            },
+        };
+    }
+};
+
+// Alternative component storage which groups entities by their signature.
+//
+// Every distinct signature gets an `Archetype`, which stores its entities in fixed-size
+// chunks. Each chunk is laid out as a struct of arrays: the entity ids first, followed
+// by one tightly packed column per component in the signature. Iterating over several
+// components at once then walks a handful of contiguous arrays per chunk instead of
+// resolving every component of every entity separately.
+//
+// Adding a component to an entity moves it to the archetype of its new signature.
+// Removing an entity from an archetype fills the hole with the archetype's last entity
+// so chunks always stay densely packed.
+template <
+    std::size_t Max_Components,
+    std::size_t Chunk_Bytes = 16384>
+class ArchetypeManager {
+    using Signature = std::bitset<Max_Components>;
+
+    static constexpr std::size_t Chunk_Alignment = 64;
+    static constexpr std::uint32_t No_Archetype = std::numeric_limits<std::uint32_t>::max();
+
+    struct ChunkDeleter {
+        void operator()(std::byte *memory) const {
+            ::operator delete[](memory, std::align_val_t(Chunk_Alignment));
+        }
+    };
+
+    using ChunkMemory = std::unique_ptr<std::byte[], ChunkDeleter>;
+
+    struct Chunk {
+        ChunkMemory memory;
+        std::size_t count = 0;
+    };
+
+    struct Archetype {
+        Signature signature = {};
+        std::vector<ComponentID> component_ids = {};
+        // byte offset of each component's column in a chunk, indexed by `ComponentID`
+        std::array<std::size_t, Max_Components> column_offsets = {};
+        std::size_t chunk_bytes = 0;
+        std::size_t capacity = 0;
+        std::vector<Chunk> chunks = {};
+        std::size_t count = 0;
+    };
+
+    struct Location {
+        std::uint32_t archetype = No_Archetype;
+        std::uint32_t chunk = 0;
+        std::uint32_t row = 0;
+    };
+
+    std::array<ComponentInfo, Max_Components> component_info = {};
+    std::vector<std::unique_ptr<Archetype>> archetypes = {};
+    std::unordered_map<Signature, std::uint32_t> archetype_lookup = {};
+    std::vector<Location> locations = {};
+
+    static std::size_t align_up(std::size_t value, std::size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Lays out the columns for `rows` entities, returning the number of bytes needed
+    std::size_t layout_columns(Archetype &archetype, std::size_t rows) const {
+        std::size_t bytes = sizeof(Entity) * rows;
+
+        for (ComponentID id : archetype.component_ids) {
+            const auto &info = component_info[id];
+            bytes = align_up(bytes, info.alignment);
+            archetype.column_offsets[id] = bytes;
+            bytes += info.size * rows;
+        }
+
+        return bytes;
+    }
+
+    std::uint32_t get_or_create_archetype(Signature signature) {
+        auto it = archetype_lookup.find(signature);
+        if (it != archetype_lookup.end()) {
+            return it->second;
+        }
+
+        auto archetype = std::make_unique<Archetype>();
+        archetype->signature = signature;
+
+        std::size_t row_bytes = sizeof(Entity);
+        for (std::size_t id = 0; id < Max_Components; id++) {
+            if (signature.test(id)) {
+                if (component_info[id].size == 0) {
+                    throw std::runtime_error("Component not registered to archetype storage");
+                }
+
+                archetype->component_ids.push_back(static_cast<ComponentID>(id));
+                row_bytes += component_info[id].size;
+            }
+        }
+
+        // shrink the row estimate until the aligned layout fits in a chunk, but always
+        // hold at least one entity even if its components are larger than a chunk
+        std::size_t rows = std::max<std::size_t>(Chunk_Bytes / row_bytes, 1);
+        while (rows > 1 && layout_columns(*archetype, rows) > Chunk_Bytes) {
+            rows--;
+        }
+
+        archetype->capacity = rows;
+        archetype->chunk_bytes = std::max(layout_columns(*archetype, rows), Chunk_Bytes);
+
+        auto index = static_cast<std::uint32_t>(archetypes.size());
+        archetypes.push_back(std::move(archetype));
+        archetype_lookup.insert({ signature, index });
+        return index;
+    }
+
+    void check_registered(ComponentID id) const {
+        if (id >= Max_Components || component_info[id].size == 0) {
+            throw std::runtime_error("Component not registered to archetype storage");
+        }
+    }
+
+    static Entity *entity_column(Chunk &chunk) {
+        return reinterpret_cast<Entity*>(chunk.memory.get());
+    }
+
+    void *component_at(Archetype &archetype, Chunk &chunk, ComponentID id, std::size_t row) {
+        return chunk.memory.get() + archetype.column_offsets[id] + component_info[id].size * row;
+    }
+
+    Location &location_of(Entity entity) {
+        if (entity.index() >= locations.size()) {
+            locations.resize(entity.index() + 1);
+        }
+
+        return locations[entity.index()];
+    }
+
+    // Reserve a row at the end of `archetype` for `entity`. The row's components are
+    // left unconstructed.
+    Location allocate_row(std::uint32_t archetype_index, Entity entity) {
+        auto &archetype = *archetypes[archetype_index];
+
+        if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+            archetype.chunks.push_back({
+                ChunkMemory(new (std::align_val_t(Chunk_Alignment)) std::byte[archetype.chunk_bytes]),
+                0
+            });
+        }
+
+        auto &chunk = archetype.chunks.back();
+        Location location = {
+            archetype_index,
+            static_cast<std::uint32_t>(archetype.chunks.size() - 1),
+            static_cast<std::uint32_t>(chunk.count)
+        };
+
+        entity_column(chunk)[chunk.count++] = entity;
+        archetype.count++;
+        return location;
+    }
+
+    // Fill the row at `location` with the last row of its archetype. The components in
+    // the row at `location` must already have been moved out or destroyed.
+    void release_row(Location location) {
+        auto &archetype = *archetypes[location.archetype];
+        auto &chunk = archetype.chunks[location.chunk];
+        auto &last_chunk = archetype.chunks.back();
+        std::size_t last_row = last_chunk.count - 1;
+
+        if (&chunk != &last_chunk || location.row != last_row) {
+            Entity moved = entity_column(last_chunk)[last_row];
+
+            for (ComponentID id : archetype.component_ids) {
+                void *src = component_at(archetype, last_chunk, id, last_row);
+                component_info[id].move_construct(component_at(archetype, chunk, id, location.row), src);
+                component_info[id].destroy(src);
+            }
+
+            entity_column(chunk)[location.row] = moved;
+            locations[moved.index()] = location;
+        }
+
+        last_chunk.count--;
+        archetype.count--;
+        if (last_chunk.count == 0) {
+            archetype.chunks.pop_back();
+        }
+    }
+
+    // Move `entity` into the archetype for `signature`, carrying over the components
+    // both archetypes share and destroying the rest
+    Location move_entity(Entity entity, Signature signature) {
+        Location from = location_of(entity);
+        Location to = allocate_row(get_or_create_archetype(signature), entity);
+
+        if (from.archetype != No_Archetype) {
+            auto &src = *archetypes[from.archetype];
+            auto &dst = *archetypes[to.archetype];
+            auto &src_chunk = src.chunks[from.chunk];
+            auto &dst_chunk = dst.chunks[to.chunk];
+
+            for (ComponentID id : src.component_ids) {
+                void *component = component_at(src, src_chunk, id, from.row);
+                if (signature.test(id)) {
+                    component_info[id].move_construct(component_at(dst, dst_chunk, id, to.row), component);
+                }
+
+                component_info[id].destroy(component);
+            }
+
+            release_row(from);
+        }
+
+        locations[entity.index()] = to;
+        return to;
+    }
+public:
+    ArchetypeManager() = default;
+    ArchetypeManager(const ArchetypeManager &rhs) = delete;
+    void operator=(const ArchetypeManager &rhs) = delete;
+
+    ~ArchetypeManager() {
+        for (auto &archetype : archetypes) {
+            for (auto &chunk : archetype->chunks) {
+                for (std::size_t row = 0; row < chunk.count; row++) {
+                    for (ComponentID id : archetype->component_ids) {
+                        component_info[id].destroy(component_at(*archetype, chunk, id, row));
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename C>
+    void register_component(ComponentID id) {
+        component_info[id] = ComponentInfo::of<C>();
+    }
+
+    template <typename C>
+    void add_component_to(Entity entity, ComponentID id, C component) {
+        check_registered(id);
+        Location location = location_of(entity);
+
+        if (location.archetype != No_Archetype && archetypes[location.archetype]->signature.test(id)) {
+            get_component<C>(entity, id) = std::move(component);
+            return;
+        }
+
+        Signature signature = {};
+        if (location.archetype != No_Archetype) {
+            signature = archetypes[location.archetype]->signature;
+        }
+
+        location = move_entity(entity, signature.set(id));
+        auto &archetype = *archetypes[location.archetype];
+        new (component_at(archetype, archetype.chunks[location.chunk], id, location.row)) C(std::move(component));
+    }
+
+    void remove_component_from(Entity entity, ComponentID id) {
+        check_registered(id);
+        if (entity.index() >= locations.size() || locations[entity.index()].archetype == No_Archetype) {
+            return;
+        }
+
+        Signature signature = archetypes[locations[entity.index()].archetype]->signature;
+        if (!signature.test(id)) {
+            return;
+        }
+
+        if (signature.reset(id).none()) {
+            entity_destroyed(entity);
+        } else {
+            move_entity(entity, signature);
+        }
+    }
+
+    template <typename C>
+    C &get_component(Entity entity, ComponentID id) {
+        check_registered(id);
+        if (entity.index() >= locations.size() || locations[entity.index()].archetype == No_Archetype
+                || !archetypes[locations[entity.index()].archetype]->signature.test(id)) {
+            throw std::runtime_error("Entity does not have component");
+        }
+
+        Location location = locations[entity.index()];
+        auto &archetype = *archetypes[location.archetype];
+        return *static_cast<C*>(component_at(archetype, archetype.chunks[location.chunk], id, location.row));
+    }
+
+    void entity_destroyed(Entity entity) {
+        if (entity.index() >= locations.size() || locations[entity.index()].archetype == No_Archetype) {
+            return;
+        }
+
+        Location location = locations[entity.index()];
+        auto &archetype = *archetypes[location.archetype];
+        auto &chunk = archetype.chunks[location.chunk];
+
+        for (ComponentID id : archetype.component_ids) {
+            component_info[id].destroy(component_at(archetype, chunk, id, location.row));
+        }
+
+        release_row(location);
+        locations[entity.index()] = {};
+    }
+
+    // Call `fn(entity, components...)` for every entity that has all of `Components`,
+    // walking the matching archetypes chunk by chunk. `ids` are the `ComponentID`s of
+    // `Components` in the same order. `fn` must not add or remove components.
+    template <typename... Components, typename Fn>
+    void for_each(const std::array<ComponentID, sizeof...(Components)> &ids, Fn &&fn) {
+        Signature mask = {};
+        for (ComponentID id : ids) {
+            check_registered(id);
+            mask.set(id);
+        }
+
+        for (auto &archetype : archetypes) {
+            if ((archetype->signature & mask) != mask) {
+                continue;
+            }
+
+            for (auto &chunk : archetype->chunks) {
+                for_each_in_chunk<Components...>(*archetype, chunk, ids, fn,
+                    std::index_sequence_for<Components...>{});
+            }
+        }
+    }
+
+    // Like `for_each`, but every chunk is a separate task on `pool`. Returns once all
+    // chunks have been visited. `fn` must not throw.
+    template <typename... Components, typename Fn>
+    void parallel_for_each(ThreadPool &pool, const std::array<ComponentID, sizeof...(Components)> &ids, Fn &&fn) {
+        Signature mask = {};
+        for (ComponentID id : ids) {
+            check_registered(id);
+            mask.set(id);
+        }
+
+        std::atomic<std::size_t> pending = 0;
+        for (auto &archetype : archetypes) {
+            if ((archetype->signature & mask) != mask) {
+                continue;
+            }
+
+            for (auto &chunk : archetype->chunks) {
+                pending++;
+                pool.submit([this, &archetype, &chunk, &ids, &fn, &pending] {
+                    for_each_in_chunk<Components...>(*archetype, chunk, ids, fn,
+                        std::index_sequence_for<Components...>{});
+                    pending.fetch_sub(1, std::memory_order_release);
+                });
+            }
+        }
+
+        pool.wait(pending);
+    }
+
+    // Memory used by each registered component type, summed over the archetypes
+    // containing it. The entity columns and chunk padding are not attributed to any
+    // component.
+    std::vector<ComponentMemoryUsage> memory_usage() const {
+        std::vector<ComponentMemoryUsage> usage;
+
+        for (std::size_t id = 0; id < Max_Components; id++) {
+            if (component_info[id].size == 0) {
+                continue;
+            }
+
+            ComponentMemoryUsage component = { .name = component_info[id].name };
+            for (const auto &archetype : archetypes) {
+                if (archetype->signature.test(id)) {
+                    component.count += archetype->count;
+                    component.capacity += archetype->capacity * archetype->chunks.size();
+                }
+            }
+
+            component.bytes = component.capacity * component_info[id].size;
+            usage.push_back(component);
+        }
+
+        return usage;
+    }
+
+    // Number of entities stored in archetypes
+    std::size_t size() const noexcept {
+        std::size_t count = 0;
+        for (const auto &archetype : archetypes) {
+            count += archetype->count;
+        }
+
+        return count;
+    }
+private:
+    template <typename... Components, typename Fn, std::size_t... Is>
+    void for_each_in_chunk(Archetype &archetype, Chunk &chunk,
+            const std::array<ComponentID, sizeof...(Components)> &ids, Fn &fn,
+            std::index_sequence<Is...>) {
+        Entity *entities = entity_column(chunk);
+        std::tuple<Components*...> columns = {
+            reinterpret_cast<Components*>(chunk.memory.get() + archetype.column_offsets[ids[Is]])...
+        };
+
+        for (std::size_t row = 0; row < chunk.count; row++) {
+            fn(entities[row], std::get<Is>(columns)[row]...);
+        }
+    }
+};
+
+}
+
+#endif // _CALICO_ARCHETYPE_MANAGER_HPP_
@@ -14,38 +14,289 @@ struct IAssetMap {
 //
 // `Asset`s are registered to the manager, which instantiates an `AssetMap` to act as
 // a storage interface of a map connecting string identifiers to instances of the `Asset`.
+// Names are resolved to `AssetHandle`s, which find their asset without hashing.
+//
+// Assets with an `AssetLoader` can also be loaded in the background with `load_async`.
+// Files are read and parsed on a thread pool, and `finalize_loads` completes the loads
+// that are ready on the thread driving the manager. `load_directory` loads every file
+// of a directory at once.
 class AssetManager {
 
-    // Map of typeids of `Asset` classes to the storage classes implementing the string to
-    // asset map for them
-    std::unordered_map<std::type_index, std::unique_ptr<IAssetMap>> asset_arrays = {};
+    // Tag numbering asset types, see `TypeFamily`
+    struct AssetFamily {};
+
+    // Storage classes implementing the string to asset map for each `Asset` class,
+    // indexed by the asset type's id in `AssetFamily`
+    std::vector<std::unique_ptr<IAssetMap>> asset_arrays = {};
+
+    template <typename Asset>
+    static std::size_t asset_id() noexcept {
+        return TypeFamily<AssetFamily>::template id<Asset>();
+    }
 
+    template <typename Asset>
+    bool is_registered() const noexcept {
+        std::size_t id = asset_id<Asset>();
+        return id < asset_arrays.size() && asset_arrays[id];
+    }
+
+    // Slot map of the assets of one type. Assets live in pages that never move, so
+    // references to them stay valid as more assets are added, and are found by name
+    // through a map keyed by the name's hash.
     template <typename Asset>
     struct AssetMap final : public IAssetMap {
-        std::unordered_map<std::string, Asset> assets = {};
+        struct Slot {
+            std::optional<Asset> asset = {};
+            std::string name = {};
+            std::uint32_t generation = 0;
+            // the last `load_async` of this name, kept after it finishes so repeated
+            // requests and state queries find it
+            std::shared_ptr<AssetLoadStatus> load = {};
+        };
+
+        PagedArray<Slot, 64> slots = {};
+        std::vector<std::uint32_t> free_slots = {};
+        std::unordered_map<AssetNameID, std::uint32_t> by_name = {};
+
+        void reserve(std::size_t n) {
+            by_name.reserve(n);
+            slots.reserve(n);
+        }
+
+        // Find the slot of `name`, allocating an empty one if there is none
+        AssetHandle<Asset> slot_of(const std::string &name) {
+            AssetNameID id = hash_asset_name(name);
+            auto existing = by_name.find(id);
+            if (existing != by_name.end()) {
+                Slot &slot = slots[existing->second];
+                if (slot.name != name) {
+                    throw std::runtime_error("Asset names '" + slot.name + "' and '" + name + "' have the same hash");
+                }
+
+                return { existing->second, slot.generation };
+            }
+
+            std::uint32_t index;
+            if (free_slots.empty()) {
+                index = static_cast<std::uint32_t>(slots.size());
+                slots.emplace_back();
+            } else {
+                index = free_slots.back();
+                free_slots.pop_back();
+            }
+
+            slots[index].name = name;
+            by_name.insert({ id, index });
+            return { index, slots[index].generation };
+        }
+
+        AssetHandle<Asset> find(AssetNameID id) const noexcept {
+            auto existing = by_name.find(id);
+            if (existing == by_name.end()) {
+                return {};
+            }
+
+            return { existing->second, slots[existing->second].generation };
+        }
+
+        Asset *get(AssetHandle<Asset> handle) noexcept {
+            if (handle.index >= slots.size()) {
+                return nullptr;
+            }
+
+            Slot &slot = slots[handle.index];
+            return slot.generation == handle.generation && slot.asset ? &*slot.asset : nullptr;
+        }
 
         // Add an asset to the map by passing a string identifier and any arguments needed
-        // to construct the asset in-place
+        // to construct the asset in-place. Returns the existing asset if there is one.
         template <typename... Args>
-        Asset &add_asset(const std::string &name, Args&&... args) noexcept {
-            assets.emplace(std::make_pair(name, Asset(args...)));
-            return assets.at(name);
+        Asset &add_asset(const std::string &name, Args&&... args) {
+            Slot &slot = slots[slot_of(name).index];
+            if (!slot.asset) {
+                slot.asset.emplace(std::forward<Args>(args)...);
+            }
+
+            return *slot.asset;
         }
 
-        std::optional<std::reference_wrapper<Asset>> get_asset(const std::string &name) {
-            if (assets.contains(name)) {
-                // need to dereference the iterator over using `at` or `[]` to avoid a copy
-                return assets.find(name)->second;
+        // Store `asset` in the slot of `handle`, destroying the asset it replaces. The
+        // new asset is moved out of `asset` before the old one is touched, so the old
+        // one is kept if that move throws.
+        void replace(AssetHandle<Asset> handle, Asset &&asset) {
+            Asset replacement(std::move(asset));
+            Slot &slot = slots[handle.index];
+            if (slot.asset) {
+                *slot.asset = std::move(replacement);
+            } else {
+                slot.asset.emplace(std::move(replacement));
             }
+        }
 
-            return std::nullopt;
+        void remove(AssetHandle<Asset> handle) {
+            if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+                return;
+            }
+
+            Slot &slot = slots[handle.index];
+            by_name.erase(hash_asset_name(slot.name));
+            slot.asset.reset();
+            slot.name.clear();
+            slot.load.reset();
+            slot.generation++;
+            free_slots.push_back(handle.index);
         }
     };
 
     // Access the storage class holding `Asset` from the asset manager's map of asset maps
     template <typename Asset>
     AssetMap<Asset> *get_array() noexcept {
-        return reinterpret_cast<AssetMap<Asset>*>(asset_arrays[std::type_index(typeid(Asset))].get());
+        return static_cast<AssetMap<Asset>*>(asset_arrays[asset_id<Asset>()].get());
+    }
+
+    template <typename Asset>
+    AssetMap<Asset> *get_registered() {
+        if (!is_registered<Asset>()) {
+            throw std::runtime_error("Asset type not registered to manager");
+        }
+
+        return get_array<Asset>();
+    }
+
+    // A load started by `load_async`, shared between the worker reading the file and
+    // the manager finalizing it
+    struct IPendingLoad {
+        virtual ~IPendingLoad() = default;
+        // Finish the load if the worker is done with it, returning whether it was
+        virtual bool try_finalize(AssetManager &manager) = 0;
+    };
+
+    template <typename Asset>
+    struct PendingLoad final : public IPendingLoad {
+        std::shared_ptr<AssetLoadStatus> status = {};
+        AssetMap<Asset> *map = nullptr;
+        AssetHandle<Asset> handle = {};
+        std::optional<typename AssetLoader<Asset>::Intermediate> data = {};
+        // set by the worker once `data` or `status->error` is filled in
+        std::atomic<bool> read = false;
+
+        void load() {
+            try {
+                data.emplace(AssetLoader<Asset>::load(status->path));
+            } catch (const std::exception &e) {
+                status->error = e.what();
+            }
+
+            read.store(true, std::memory_order_release);
+        }
+
+        bool try_finalize(AssetManager &manager) override {
+            if (!read.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            if (data) {
+                try {
+                    // the asset may have been removed, or reloaded again, while loading
+                    auto &slot = map->slots[handle.index];
+                    if (slot.generation != handle.generation || slot.load != status) {
+                        throw std::runtime_error("Load superseded before it finished");
+                    }
+
+                    std::vector<std::string> files = { status->path };
+                    if constexpr (requires { AssetLoader<Asset>::dependencies(*data); }) {
+                        for (auto &file : AssetLoader<Asset>::dependencies(*data)) {
+                            files.push_back(std::move(file));
+                        }
+                    }
+
+                    // a failure leaves the asset being reloaded in place
+                    map->replace(handle, AssetLoader<Asset>::finalize(std::move(*data)));
+                    status->state.store(AssetState::Loaded, std::memory_order_release);
+
+                    for (const auto &file : files) {
+                        manager.watch_file(file, map, handle, status->path);
+                    }
+
+                    return true;
+                } catch (const std::exception &e) {
+                    status->error = e.what();
+                }
+            }
+
+            status->state.store(AssetState::Failed, std::memory_order_release);
+            return true;
+        }
+    };
+
+    std::vector<std::shared_ptr<IPendingLoad>> pending_loads = {};
+
+    // Asset to reload when a file it was loaded from changes
+    struct WatchedAsset {
+        IAssetMap *map = nullptr;
+        std::uint32_t index = 0;
+        std::function<void(AssetManager &manager, ThreadPool &pool)> reload = {};
+    };
+
+    // Assets loaded from each file, keyed by the file's canonical path
+    std::unordered_map<std::string, std::vector<WatchedAsset>> watched = {};
+    std::unique_ptr<FileWatcher> watcher = {};
+
+    template <typename Asset>
+    AssetLoad start_load(ThreadPool &pool, AssetMap<Asset> *map, AssetHandle<Asset> handle, const std::string &path) {
+        auto status = std::make_shared<AssetLoadStatus>();
+        status->name = map->slots[handle.index].name;
+        status->path = path;
+
+        auto load = std::make_shared<PendingLoad<Asset>>();
+        load->status = status;
+        load->map = map;
+        load->handle = handle;
+
+        map->slots[handle.index].load = status;
+        pending_loads.push_back(load);
+        // file I/O and parsing block, keep them off threads waiting on the pool
+        pool.submit_background([load] { load->load(); });
+
+        return status;
+    }
+
+    // Reload the asset at `handle` from `path` when `file` changes. Failing to watch
+    // `file` is logged rather than thrown, since the asset itself loaded fine.
+    template <typename Asset>
+    void watch_file(const std::string &file, AssetMap<Asset> *map, AssetHandle<Asset> handle, const std::string &path) {
+        std::error_code error;
+        auto key = std::filesystem::weakly_canonical(file, error).string();
+        if (error) {
+            return;
+        }
+
+        auto &assets = watched[key];
+        for (const auto &asset : assets) {
+            if (asset.map == map && asset.index == handle.index) {
+                return;
+            }
+        }
+
+        assets.push_back({
+            .map = map,
+            .index = handle.index,
+            .reload = [map, handle, path](AssetManager &manager, ThreadPool &pool) {
+                // skip assets removed since
+                if (map->slots[handle.index].generation == handle.generation) {
+                    manager.start_load(pool, map, handle, path);
+                }
+            },
+        });
+
+        // the asset is loaded either way, it just won't be reloaded when `file` changes
+        if (watcher) {
+            try {
+                watcher->watch(key);
+            } catch (const std::exception &e) {
+                Logger::get().log(Logger::Level::Warning, "Not watching '%s' for changes: %s", key.c_str(), e.what());
+            }
+        }
     }
 
 public:
@@ -53,45 +304,302 @@ public:
     // in memory
     template <typename Asset>
     void register_asset() {
-        if (asset_arrays.contains(std::type_index(typeid(Asset)))) {
+        if (is_registered<Asset>()) {
             throw std::runtime_error("Asset already registered to manager");
         } else {
-            asset_arrays.insert({
-                std::type_index(typeid(Asset)),
-                std::make_unique<AssetMap<Asset>>()
-            });
+            if (asset_id<Asset>() >= asset_arrays.size()) {
+                asset_arrays.resize(asset_id<Asset>() + 1);
+            }
+
+            asset_arrays[asset_id<Asset>()] = std::make_unique<AssetMap<Asset>>();
         }
     }
 
-    // Instantiates an asset 
+    // Reserve space for `n` assets of type `Asset`
+    template <typename Asset>
+    void reserve(std::size_t n) {
+        get_registered<Asset>()->reserve(n);
+    }
+
+    // Instantiates an asset, or returns the asset already stored under `name`
     template <typename Asset, typename... Args>
     Asset &add_asset(const std::string &name, Args&&... args) {
-        if (!asset_arrays.contains(std::type_index(typeid(Asset)))) {
-            throw std::runtime_error("Asset type not registered to manager");
-        } else {
-            return get_array<Asset>()->add_asset(name, std::forward<Args>(args)...);
-        }
+        return get_registered<Asset>()->add_asset(name, std::forward<Args>(args)...);
+    }
+
+    // Handle to the asset stored or being loaded under `name`, or a null handle. Resolve
+    // names once and keep the handle rather than looking assets up by name every time.
+    template <typename Asset>
+    AssetHandle<Asset> get_handle(AssetNameID id) {
+        return get_registered<Asset>()->find(id);
+    }
+
+    template <typename Asset>
+    AssetHandle<Asset> get_handle(std::string_view name) {
+        return get_handle<Asset>(hash_asset_name(name));
+    }
+
+    // The asset `handle` refers to, or null if it was removed or hasn't finished loading
+    template <typename Asset>
+    Asset *get_asset(AssetHandle<Asset> handle) {
+        return get_registered<Asset>()->get(handle);
     }
 
     // Optionally return a reference to the asset identified by `name` if the asset exists
     template <typename Asset>
     std::optional<std::reference_wrapper<Asset>> get_asset(const std::string &name) {
-        if (!asset_arrays.contains(std::type_index(typeid(Asset)))) {
-            throw std::runtime_error("Asset type not registered to manager");
-        } else {
-            return get_array<Asset>()->get_asset(name);
+        Asset *asset = get_asset(get_handle<Asset>(name));
+        if (asset) {
+            return *asset;
         }
+
+        return std::nullopt;
     }
 
-    // Return the map holding all assets of type `Asset`
+    // Destroy the asset `handle` refers to, invalidating every handle to it
     template <typename Asset>
-    std::unordered_map<std::string, Asset> &get_all_assets() {
-        if (!asset_arrays.contains(std::type_index(typeid(Asset)))) {
-            throw std::runtime_error("Asset type not registered to manager");
-        } else {
-            return get_array<Asset>()->assets;
+    void remove_asset(AssetHandle<Asset> handle) {
+        get_registered<Asset>()->remove(handle);
+    }
+
+    // Call `fn(name, asset)` for every `Asset` stored
+    template <typename Asset, typename Fn>
+    void for_each_asset(Fn &&fn) {
+        auto *map = get_registered<Asset>();
+        for (std::size_t i = 0; i < map->slots.size(); i++) {
+            auto &slot = map->slots[i];
+            if (slot.asset) {
+                fn(static_cast<const std::string&>(slot.name), *slot.asset);
+            }
+        }
+    }
+
+    // Start loading the `Asset` at `path` on `pool`, to be stored under `name` once
+    // `finalize_loads` has completed it. Handles to `name` are available right away and
+    // resolve to the asset once it is loaded. Requesting a name that is already loaded
+    // or loading returns the existing load rather than starting another; a failed load
+    // is retried.
+    template <typename Asset>
+    AssetLoad load_async(ThreadPool &pool, const std::string &name, const std::string &path) {
+        auto *map = get_registered<Asset>();
+        auto handle = map->slot_of(name);
+        auto &slot = map->slots[handle.index];
+
+        if (slot.load && slot.load->get_state() != AssetState::Failed) {
+            return slot.load;
+        }
+
+        if (slot.asset) {
+            // added directly through `add_asset`
+            auto status = std::make_shared<AssetLoadStatus>();
+            status->name = name;
+            status->path = path;
+            status->state.store(AssetState::Loaded, std::memory_order_relaxed);
+            return status;
+        }
+
+        return start_load(pool, map, handle, path);
+    }
+
+    // Complete every load whose file has been read, moving the results into the asset
+    // maps. Must be called from the thread driving the manager.
+    void finalize_loads() {
+        std::erase_if(pending_loads, [this](const auto &load) { return load->try_finalize(*this); });
+    }
+
+    // Reload assets loaded through `load_async` when the files they were loaded from
+    // change. A reloaded asset replaces the old one in place, so handles and references
+    // to it stay valid; if the reload fails the old asset is kept and the error is
+    // reported by `get_load`.
+    void enable_hot_reload(std::chrono::milliseconds debounce = std::chrono::milliseconds(150)) {
+        watcher = std::make_unique<FileWatcher>(debounce);
+        for (const auto &[file, assets] : watched) {
+            // a file that can't be watched shouldn't stop the others from reloading
+            try {
+                watcher->watch(file);
+            } catch (const std::exception &e) {
+                Logger::get().log(Logger::Level::Warning, "Not watching '%s' for changes: %s", file.c_str(), e.what());
+            }
         }
     }
+
+    // Start reloading the assets whose files changed. Must be called from the thread
+    // driving the manager; the reloads complete in a later `finalize_loads`.
+    void poll_changes(ThreadPool &pool) {
+        if (!watcher) {
+            return;
+        }
+
+        for (const auto &file : watcher->poll()) {
+            auto assets = watched.find(file);
+            if (assets == watched.end()) {
+                continue;
+            }
+
+            for (const auto &asset : assets->second) {
+                asset.reload(*this, pool);
+            }
+        }
+    }
+
+    // Load every file under `directory` ending in `extension`, storing each asset under
+    // the name its loader gives it, and wait for them all.
+    //
+    // Files are read and then parsed in parallel on `pool`, and the results inserted
+    // into the asset map, reserved once for all of them, on the calling thread. An asset
+    // already stored under the same name is replaced in place. A file that fails to load
+    // is recorded in the result and doesn't stop the others, as are directories that
+    // can't be read and entries such as dangling symlinks. Loaded files are watched for
+    // changes like those loaded with `load_async`.
+    template <DirectoryLoadable Asset>
+    DirectoryLoadResult load_directory(ThreadPool &pool, const std::string &directory,
+        std::string_view extension = ".xml") {
+
+        using Clock = std::chrono::steady_clock;
+        using Intermediate = typename AssetLoader<Asset>::Intermediate;
+
+        auto *map = get_registered<Asset>();
+        DirectoryLoadResult result;
+
+        auto start = Clock::now();
+
+        // walk one directory at a time rather than with `recursive_directory_iterator`,
+        // which ends the whole walk at the first directory it fails to read
+        std::vector<std::string> paths;
+        std::vector<std::filesystem::path> directories = { directory };
+        while (!directories.empty()) {
+            auto current = std::move(directories.back());
+            directories.pop_back();
+
+            std::error_code error;
+            std::filesystem::directory_iterator entry(current, std::filesystem::directory_options::skip_permission_denied, error);
+            for (; !error && entry != std::filesystem::directory_iterator(); entry.increment(error)) {
+                // symlinks to directories aren't followed, so links can't form a cycle
+                std::error_code entry_error;
+                if (entry->symlink_status(entry_error).type() == std::filesystem::file_type::directory) {
+                    directories.push_back(entry->path());
+                } else if (entry->path().extension() == extension) {
+                    if (entry->is_regular_file(entry_error)) {
+                        paths.push_back(entry->path().string());
+                    } else if (entry_error) {
+                        result.errors.push_back({ entry->path().string(), entry_error.message() });
+                    }
+                }
+            }
+
+            if (error) {
+                result.errors.push_back({ current.string(), error.message() });
+            }
+        }
+
+        // the order files are inserted in decides which of two with the same name wins,
+        // so don't leave it to the file system
+        std::sort(paths.begin(), paths.end());
+        result.files = paths.size();
+
+        auto enumerated = Clock::now();
+        result.timings.enumerate = enumerated - start;
+
+        // each element is only touched by the thread handling its file
+        std::vector<std::string> errors(paths.size());
+        std::vector<std::optional<MappedFile>> files(paths.size());
+
+        parallel_for(pool, paths.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                try {
+                    files[i].emplace(paths[i]);
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+            }
+        });
+
+        auto read = Clock::now();
+        result.timings.read = read - enumerated;
+
+        std::vector<std::optional<Intermediate>> parsed(paths.size());
+
+        parallel_for(pool, paths.size(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (!files[i]) {
+                    continue;
+                }
+
+                try {
+                    parsed[i].emplace(AssetLoader<Asset>::parse(files[i]->view(), paths[i]));
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+
+                files[i].reset();
+            }
+        });
+
+        auto parse_end = Clock::now();
+        result.timings.parse = parse_end - read;
+
+        map->reserve(map->by_name.size() + paths.size());
+        std::unordered_set<std::string> inserted;
+        inserted.reserve(paths.size());
+
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            if (!parsed[i]) {
+                result.errors.push_back({ paths[i], std::move(errors[i]) });
+                continue;
+            }
+
+            try {
+                std::string name = AssetLoader<Asset>::name(*parsed[i]);
+                if (inserted.contains(name)) {
+                    throw std::runtime_error("Asset '" + name + "' is also loaded from another file");
+                }
+
+                // only take a slot for the name once there is an asset to put in it
+                Asset asset = AssetLoader<Asset>::finalize(std::move(*parsed[i]));
+                auto handle = map->slot_of(name);
+                map->replace(handle, std::move(asset));
+                inserted.insert(name);
+                // supersedes any `load_async` of the name still in flight
+                map->slots[handle.index].load.reset();
+                watch_file(paths[i], map, handle, paths[i]);
+                result.loaded++;
+            } catch (const std::exception &e) {
+                result.errors.push_back({ paths[i], e.what() });
+            }
+        }
+
+        result.timings.insert = Clock::now() - parse_end;
+        return result;
+    }
+
+    // Number of loads started by `load_async` that haven't been finalized yet
+    std::size_t pending_load_count() const noexcept {
+        return pending_loads.size();
+    }
+
+    // The latest load of `name`, including reloads, or null if it was never loaded
+    template <typename Asset>
+    AssetLoad get_load(const std::string &name) {
+        auto *map = get_registered<Asset>();
+        auto handle = map->find(hash_asset_name(name));
+        return handle.is_null() ? nullptr : map->slots[handle.index].load;
+    }
+
+    template <typename Asset>
+    AssetState get_state(const std::string &name) {
+        auto *map = get_registered<Asset>();
+        auto handle = map->find(hash_asset_name(name));
+        if (handle.is_null()) {
+            return AssetState::Missing;
+        }
+
+        const auto &slot = map->slots[handle.index];
+        if (slot.asset) {
+            return AssetState::Loaded;
+        }
+
+        return slot.load ? slot.load->get_state() : AssetState::Missing;
+    }
 };
 
 }
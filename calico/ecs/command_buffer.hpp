@@ -0,0 +1,283 @@
+#ifndef _CALICO_COMMAND_BUFFER_HPP_
+#define _CALICO_COMMAND_BUFFER_HPP_
+
+namespace Calico {
+
+class ECSManager;
+
+// An entity created through a `CommandBuffer`. It only becomes an `Entity` when the
+// buffer is played back, but can already be the target of later commands recorded
+// in the same buffer.
+struct PendingEntity {
+    std::uint32_t index;
+};
+
+// Records structural changes to an `ECSManager` (creating and deleting entities,
+// adding and removing components) so that they can be applied later from a single
+// thread. Component values are stored in an arena which is reused from frame to frame.
+//
+// A buffer must only be recorded to by one thread at a time; `CommandQueue` hands out
+// one buffer per thread.
+class CommandBuffer {
+public:
+    // Commands on different entities are played back in this order, see
+    // `CommandQueue::play_back`
+    enum class Kind : std::uint8_t {
+        Create,
+        AddComponent,
+        RemoveComponent,
+        Delete,
+    };
+
+    struct Command {
+        Kind kind;
+        bool pending = false;
+        // index of the `PendingEntity` targeted when `pending` is set, otherwise the
+        // target is `entity`, which is filled in for pending entities during playback
+        std::uint32_t pending_index = 0;
+        Entity entity = {};
+        // filled in during playback
+        ComponentID component = 0;
+        // number of commands recorded before this one on the same entity, filled in
+        // during playback
+        std::uint32_t stage = 0;
+        void *payload = nullptr;
+        ComponentID (*component_id)(ECSManager &) = nullptr;
+        void (*apply)(ECSManager &, Entity, void *) = nullptr;
+        void (*discard)(void *) = nullptr;
+    };
+private:
+    friend class CommandQueue;
+
+    Arena arena;
+    std::vector<Command> commands = {};
+    std::vector<Entity> created = {};
+    std::uint32_t pending_entities = 0;
+
+    template <typename ECS, typename C>
+    static ComponentID component_id_of(ECS &ecs) {
+        return ecs.template get_component_id<C>();
+    }
+
+    // Adding to or removing from an entity deleted earlier in playback, possibly by
+    // another thread's buffer, does nothing, like deleting it again
+    template <typename ECS, typename C>
+    static void apply_add(ECS &ecs, Entity entity, void *payload) {
+        C *component = static_cast<C*>(payload);
+        if (ecs.is_alive(entity)) {
+            ecs.template add_component_to<C>(entity, std::move(*component));
+        }
+
+        component->~C();
+    }
+
+    template <typename ECS, typename C>
+    static void apply_remove(ECS &ecs, Entity entity, void *) {
+        if (ecs.is_alive(entity)) {
+            ecs.template remove_component_from<C>(entity);
+        }
+    }
+
+    template <typename ECS>
+    static void apply_delete(ECS &ecs, Entity entity, void *) {
+        ecs.delete_entity(entity);
+    }
+
+    template <typename C>
+    static void discard_component(void *payload) {
+        static_cast<C*>(payload)->~C();
+    }
+
+    template <typename C>
+    void record_add(bool pending, std::uint32_t pending_index, Entity entity, C &&component) {
+        using Component = std::remove_cvref_t<C>;
+        commands.push_back({
+            .kind = Kind::AddComponent,
+            .pending = pending,
+            .pending_index = pending_index,
+            .entity = entity,
+            .payload = arena.create<Component>(std::forward<C>(component)),
+            .component_id = &component_id_of<ECSManager, Component>,
+            .apply = &apply_add<ECSManager, Component>,
+            .discard = &discard_component<Component>,
+        });
+    }
+
+    template <typename C>
+    void record_remove(bool pending, std::uint32_t pending_index, Entity entity) {
+        commands.push_back({
+            .kind = Kind::RemoveComponent,
+            .pending = pending,
+            .pending_index = pending_index,
+            .entity = entity,
+            .component_id = &component_id_of<ECSManager, C>,
+            .apply = &apply_remove<ECSManager, C>,
+        });
+    }
+
+    void record_delete(bool pending, std::uint32_t pending_index, Entity entity) {
+        commands.push_back({
+            .kind = Kind::Delete,
+            .pending = pending,
+            .pending_index = pending_index,
+            .entity = entity,
+            .apply = &apply_delete<ECSManager>,
+        });
+    }
+public:
+    CommandBuffer() = default;
+    CommandBuffer(CommandBuffer &&rhs) = default;
+    CommandBuffer(const CommandBuffer &rhs) = delete;
+    void operator=(const CommandBuffer &rhs) = delete;
+
+    ~CommandBuffer() {
+        clear();
+    }
+
+    PendingEntity new_entity() {
+        return { pending_entities++ };
+    }
+
+    void delete_entity(Entity entity) {
+        record_delete(false, 0, entity);
+    }
+
+    void delete_entity(PendingEntity entity) {
+        record_delete(true, entity.index, {});
+    }
+
+    template <typename Component>
+    void add_component_to(Entity entity, Component component) {
+        record_add(false, 0, entity, std::move(component));
+    }
+
+    template <typename Component>
+    void add_component_to(PendingEntity entity, Component component) {
+        record_add(true, entity.index, {}, std::move(component));
+    }
+
+    template <typename Component>
+    void remove_component_from(Entity entity) {
+        record_remove<Component>(false, 0, entity);
+    }
+
+    template <typename Component>
+    void remove_component_from(PendingEntity entity) {
+        record_remove<Component>(true, entity.index, {});
+    }
+
+    bool empty() const noexcept {
+        return commands.empty() && pending_entities == 0;
+    }
+
+    // Drop every recorded command without applying it
+    void clear() {
+        for (auto &command : commands) {
+            if (command.payload && command.discard) {
+                command.discard(command.payload);
+            }
+        }
+
+        commands.clear();
+        created.clear();
+        pending_entities = 0;
+        arena.reset();
+    }
+};
+
+// One `CommandBuffer` per thread of a `ThreadPool`, played back together.
+//
+// Recording is lock-free since every thread only writes to its own buffer. Threads
+// outside the pool share the buffer of the thread driving the pool, so only the
+// pool's workers and that thread may record.
+class CommandQueue {
+    PerThread<CommandBuffer> buffers;
+    std::vector<CommandBuffer::Command*> batch = {};
+    // commands seen so far during playback, indexed by entity index. Only the entries
+    // of entities in `batch` are non-zero.
+    std::vector<std::uint32_t> stages = {};
+
+    // Clears the batch and the buffers when playback ends, even if a command threw, so
+    // the commands not applied yet are dropped rather than played back twice
+    struct ClearOnExit {
+        CommandQueue &queue;
+
+        ~ClearOnExit() {
+            for (const auto *command : queue.batch) {
+                queue.stages[command->entity.index()] = 0;
+            }
+
+            queue.batch.clear();
+            queue.buffers.for_each([](CommandBuffer &buffer) {
+                buffer.clear();
+            });
+        }
+    };
+public:
+    explicit CommandQueue(const ThreadPool &pool) : buffers(pool) {}
+
+    // The calling thread's buffer
+    CommandBuffer &local() noexcept {
+        return buffers.local();
+    }
+
+    // Apply every recorded command to `ecs` and clear the buffers. Must not run while
+    // any thread is recording.
+    //
+    // Pending entities are created first. The other commands on an entity are applied
+    // in the order they were recorded, buffer by buffer, so removing a component then
+    // adding it again leaves the entity with it. Commands on different entities
+    // commute, so each round of at most one command per entity is sorted by kind and
+    // component: components are added, then removed, then entities are deleted, with
+    // additions and removals grouped by component type so that every `ComponentArray`
+    // is written in one go.
+    template <typename ECS>
+    void play_back(ECS &ecs) {
+        ClearOnExit clear_on_exit{ *this };
+        batch.clear();
+
+        buffers.for_each([&ecs, this](CommandBuffer &buffer) {
+            for (std::uint32_t i = 0; i < buffer.pending_entities; i++) {
+                buffer.created.push_back(ecs.new_entity());
+            }
+
+            for (auto &command : buffer.commands) {
+                if (command.pending) {
+                    command.entity = buffer.created[command.pending_index];
+                }
+
+                if (command.component_id) {
+                    command.component = command.component_id(ecs);
+                }
+
+                std::uint32_t index = command.entity.index();
+                if (index >= stages.size()) {
+                    stages.resize(index + 1, 0);
+                }
+
+                batch.push_back(&command);
+                command.stage = stages[index]++;
+            }
+        });
+
+        std::stable_sort(batch.begin(), batch.end(), [](const auto *lhs, const auto *rhs) {
+            if (lhs->stage != rhs->stage) {
+                return lhs->stage < rhs->stage;
+            } else if (lhs->kind != rhs->kind) {
+                return lhs->kind < rhs->kind;
+            }
+
+            return lhs->component < rhs->component;
+        });
+
+        for (auto *command : batch) {
+            command->apply(ecs, command->entity, command->payload);
+            // payloads are consumed by `apply`
+            command->payload = nullptr;
+        }
+    }
+};
+
+}
+
+#endif // _CALICO_COMMAND_BUFFER_HPP_
@@ -3,84 +3,128 @@
 
 namespace Calico {
 
+// Memory held by the storage of one component type
+struct ComponentMemoryUsage {
+    const char *name = nullptr;
+    // number of components stored
+    std::size_t count = 0;
+    // number of components that fit in the memory already allocated
+    std::size_t capacity = 0;
+    // bytes allocated for the components and the structures indexing them
+    std::size_t bytes = 0;
+};
+
 // Interface for the `ComponentArray`s instantiated by the `ComponentManager`
 struct IComponentArray {
     virtual ~IComponentArray() = default;
     virtual void on_entity_destroyed(Entity entity) = 0;
+    virtual ComponentMemoryUsage memory_usage() const = 0;
 };
 
 // Manages `Component`s which can be associated with entities allocated by the game engine.
-// 
+//
+// Storage for each component type grows a page at a time as components are added, so
+// a component type only costs memory in proportion to the number of entities using it.
 template <
-    std::size_t Max_Components,
-    std::size_t Max_Objects>
+    std::size_t Max_Components>
 class ComponentManager {
-
+public:
     template <typename C>
     struct ComponentArray final : public IComponentArray {
     private:
-        std::array<C, Max_Objects> component_array;
-        std::unordered_map<Entity, Index> entity_to_component;
-        std::unordered_map<Index, Entity> component_to_entity;
+        // `component_array[i]` belongs to the entity at position `i` of `entities`
+        PagedArray<C> component_array;
+        SparseSet<> entities;
         const char *name = typeid(C).name(); // debug
-        std::size_t current_index = 0;
     public:
         ComponentArray() = default;
         ~ComponentArray() = default;
 
         void insert_entity(Entity entity, C component) {
-            component_array[current_index] = component;
-            entity_to_component.insert({ entity, current_index });
-            component_to_entity.insert({ current_index, entity });
-            current_index++;
+            if (entities.contains(entity)) {
+                component_array[entities.index_of(entity)] = std::move(component);
+            } else {
+                entities.insert(entity);
+                component_array.emplace_back(std::move(component));
+            }
         }
 
         C &get_component(Entity entity) {
-            return component_array[entity_to_component[entity]];
+            return component_array[entities.index_of(entity)];
+        }
+
+        // Entities holding this component, in the same order as their components
+        const SparseSet<> &get_entities() const noexcept {
+            return entities;
+        }
+
+        std::size_t size() const noexcept {
+            return entities.size();
         }
 
         void on_entity_destroyed(Entity entity) override {
             // do nothing if entity is not registered to this component
-            if (!entity_to_component.contains(entity)) {
+            if (!entities.contains(entity)) {
                 return;
             }
 
-            // nothing to swap with if this is the last entity registered
-            // to this component
-            if (current_index == 1) {
-                current_index--;
-                return;
+            // move the last component into the destroyed entity's slot, mirroring
+            // what the sparse set does with the entity list
+            Index last = static_cast<Index>(entities.size() - 1);
+            Index index = entities.erase(entity);
+            if (index != last) {
+                component_array[index] = std::move(component_array[last]);
             }
 
-            // swap last index and index of destroyed entity
-            // set swapped entity's index to destroyed entity's index
-            // delete destroyed entity
-            Index component_to_swap = current_index - 1;
-            Entity entity_to_swap = component_to_entity[component_to_swap];
-
-            std::swap(get_component(entity), get_component(entity_to_swap));
-            std::swap(entity_to_component[entity], entity_to_component[entity_to_swap]);
-            // entity_to_component[entity] = component_to_swap;
-            // entity_to_component[entity_to_swap] = component;
-            std::printf("%s notified that %d was destroyed\n", this->name, entity);
-            current_index--;
+            component_array.pop_back();
+        }
+
+        ComponentMemoryUsage memory_usage() const override {
+            return {
+                .name = name,
+                .count = component_array.size(),
+                .capacity = component_array.capacity(),
+                .bytes = component_array.allocated_bytes() + entities.allocated_bytes(),
+            };
         }
     };
 
-    std::unordered_map<const char*, ComponentID> component_ids = {};
-    std::unordered_map<const char*, std::unique_ptr<IComponentArray>> components = {};
-    ComponentID next_component_id = 0;
+private:
+    // Tag numbering component types, see `TypeFamily`
+    struct ComponentFamily {};
+
+    // Component arrays indexed by `ComponentID`
+    std::array<std::unique_ptr<IComponentArray>, Max_Components> components = {};
 
+public:
     template <typename C>
     ComponentArray<C> *get_array() {
-        return reinterpret_cast<ComponentArray<C>*>(components[typeid(C).name()].get());
+        auto &array = components[get_component_id<C>()];
+        if (!array) {
+            throw std::runtime_error("Component type not registered");
+        }
+
+        return static_cast<ComponentArray<C>*>(array.get());
+    }
+
+    // Assign `C` a `ComponentID` without allocating storage for it, for when components
+    // are stored elsewhere (e.g. in archetypes)
+    template <typename C>
+    ComponentID register_component_id() {
+        std::size_t id = TypeFamily<ComponentFamily>::template id<C>();
+        if (id >= Max_Components) {
+            throw std::runtime_error("Too many component types, increase Max_Components");
+        }
+
+        return static_cast<ComponentID>(id);
     }
 
-public:
     template <typename C>
     void register_component() {
-        component_ids.insert({ typeid(C).name(), next_component_id++ });
-        components.insert({ typeid(C).name(), std::make_unique<ComponentArray<C>>() });
+        auto &array = components[register_component_id<C>()];
+        if (!array) {
+            array = std::make_unique<ComponentArray<C>>();
+        }
     }
 
     template <typename C>
@@ -88,20 +132,47 @@ public:
         get_array<C>()->insert_entity(entity, component);
     }
 
+    template <typename C>
+    void remove_component_from(Entity entity) {
+        get_array<C>()->on_entity_destroyed(entity);
+    }
+
     template <typename Component>
     Component &get_component(Entity entity) {
         return get_array<Component>()->get_component(entity);
     }
 
+    // Ids are handed out per type rather than per manager, so this is a load of a
+    // function-local static. Throws for ids past `Max_Components`, which no registered
+    // type has.
     template <typename Component>
-    ComponentID get_component_id() {
-        return component_ids[typeid(Component).name()];
+    static ComponentID get_component_id() {
+        std::size_t id = TypeFamily<ComponentFamily>::template id<Component>();
+        if (id >= Max_Components) {
+            throw std::runtime_error("Component type not registered");
+        }
+
+        return static_cast<ComponentID>(id);
+    }
+
+    // Memory used by every registered component type
+    std::vector<ComponentMemoryUsage> memory_usage() const {
+        std::vector<ComponentMemoryUsage> usage;
+        for (const auto &component : components) {
+            if (component) {
+                usage.push_back(component->memory_usage());
+            }
+        }
+
+        return usage;
     }
 
     void entity_destroyed(Entity entity) {
         // inform all component arrays that `entity` was destroyed
-        for (const auto &[name, component] : components) {
-            component->on_entity_destroyed(entity);
+        for (const auto &component : components) {
+            if (component) {
+                component->on_entity_destroyed(entity);
+            }
         }
     }
 };
@@ -4,20 +4,41 @@
 namespace Calico {
 
 constexpr std::size_t Max_Components = 64;
-constexpr std::size_t Max_Objects = 65535;
+
+// Where an `ECSManager` keeps its components.
+//
+// `Sparse` stores each component type in its own `ComponentArray`, which makes adding
+// and removing components cheap. `Archetype` groups entities with the same signature
+// into chunks, which makes iterating over several components at once cheap at the cost
+// of moving an entity's components whenever its signature changes.
+enum class Storage {
+    Sparse,
+    Archetype,
+};
 
 class ECSManager {
 private:
-    std::unique_ptr<ComponentManager<Max_Components, Max_Objects>> component_manager =
-        std::make_unique<ComponentManager<Max_Components, Max_Objects>>();
-    std::unique_ptr<EntityManager<Max_Components, Max_Objects>> entity_manager =
-        std::make_unique<EntityManager<Max_Components, Max_Objects>>();
+    Storage storage = Storage::Sparse;
+    std::unique_ptr<ComponentManager<Max_Components>> component_manager =
+        std::make_unique<ComponentManager<Max_Components>>();
+    std::unique_ptr<ArchetypeManager<Max_Components>> archetype_manager =
+        std::make_unique<ArchetypeManager<Max_Components>>();
+    std::unique_ptr<EntityManager<Max_Components>> entity_manager =
+        std::make_unique<EntityManager<Max_Components>>();
     std::unique_ptr<SystemManager<Max_Components>> system_manager =
         std::make_unique<SystemManager<Max_Components>>();
     std::unique_ptr<EventManager> event_manager = std::make_unique<EventManager>();
     std::unique_ptr<AssetManager> asset_manager = std::make_unique<AssetManager>();
+    std::unique_ptr<ThreadPool> thread_pool = std::make_unique<ThreadPool>();
+    std::unique_ptr<CommandQueue> command_queue = std::make_unique<CommandQueue>(*thread_pool);
+    void check_alive(Entity entity) const {
+        if (!entity_manager->is_alive(entity)) {
+            throw std::runtime_error("Stale entity handle");
+        }
+    }
 public:
     ECSManager() {}
+    explicit ECSManager(Storage storage) : storage(storage) {}
 
     // System manipulation functions
     template <typename System>
@@ -28,18 +49,44 @@ public:
         return system;
     }
 
+    // Require `Component` for entities handled by `System`. `access` declares whether
+    // `System::update` only reads the component or may also write it, which decides
+    // which systems `run_systems` may update at the same time.
     template <
         typename System,
-        typename Component>
+        typename Component,
+        Access access = Access::Write>
     void add_system_signature() {
         auto component_id = component_manager->template get_component_id<Component>();
-        system_manager->template add_signature<System>(component_id);
+        system_manager->template add_signature<System>(component_id, access);
+    }
+
+    // Finish the asset loads that are ready, start reloading assets whose files changed
+    // and deliver the events queued since the last frame, then update every registered
+    // system once, running systems with non-conflicting component access concurrently
+    // on the thread pool. Returns once all systems have finished and the commands they
+    // recorded have been played back.
+    void run_systems(float dt) {
+        asset_manager->finalize_loads();
+        asset_manager->poll_changes(*thread_pool);
+        event_manager->dispatch_queued();
+        system_manager->run(*thread_pool, dt);
+        flush_commands();
+    }
+
+    ThreadPool &get_thread_pool() {
+        return *thread_pool;
     }
 
     // Component manipulation functions
     template <typename Component>
     void register_component() {
-        component_manager->template register_component<Component>();
+        if (storage == Storage::Archetype) {
+            auto component_id = component_manager->template register_component_id<Component>();
+            archetype_manager->template register_component<Component>(component_id);
+        } else {
+            component_manager->template register_component<Component>();
+        }
     }
 
     // Entity manipulation functions
@@ -47,16 +94,52 @@ public:
         return entity_manager->new_entity();
     }
 
+    // Make room for `n` entities up front rather than growing as they are created
+    void reserve_entities(std::size_t n) {
+        entity_manager->reserve(n);
+    }
+
+    // Deletes `entity` and its components. Deleting an entity that is no longer alive
+    // does nothing.
     void delete_entity(Entity entity) {
-        return entity_manager->delete_entity(entity);
+        if (!entity_manager->is_alive(entity)) {
+            return;
+        }
+
+        if (storage == Storage::Archetype) {
+            archetype_manager->entity_destroyed(entity);
+        } else {
+            component_manager->entity_destroyed(entity);
+        }
+
+        system_manager->on_entity_destroyed(entity, entity_manager->get_signature(entity));
+        entity_manager->delete_entity(entity);
+    }
+
+    // Whether `entity` is a handle to an entity that has not been deleted since
+    bool is_alive(Entity entity) const noexcept {
+        return entity_manager->is_alive(entity);
     }
 
     template <typename Component>
     void add_component_to(Entity entity, Component component) {
+        check_alive(entity);
         auto component_id = component_manager->template get_component_id<Component>();
+        bool signature_changed = !entity_manager->get_signature(entity).test(component_id);
+
+        // store the component first so an unregistered type leaves the signature alone
+        if (storage == Storage::Archetype) {
+            archetype_manager->add_component_to(entity, component_id, std::move(component));
+        } else {
+            component_manager->template add_component_to<Component>(entity, component);
+        }
+
         entity_manager->add_component_to(entity, component_id);
-        component_manager->template add_component_to<Component>(entity, component);
-        system_manager->on_add_component(entity, entity_manager->get_signature(entity));
+
+        // replacing an existing component can't change which systems the entity is in
+        if (signature_changed) {
+            system_manager->on_add_component(entity, component_id, entity_manager->get_signature(entity));
+        }
     }
 
     template <typename Component, typename... Args>
@@ -68,16 +151,164 @@ public:
         }
     }
 
+    template <typename Component>
+    void remove_component_from(Entity entity) {
+        check_alive(entity);
+        auto component_id = component_manager->template get_component_id<Component>();
+        if (!entity_manager->get_signature(entity).test(component_id)) {
+            return;
+        }
+
+        entity_manager->remove_component_from(entity, component_id);
+
+        if (storage == Storage::Archetype) {
+            archetype_manager->remove_component_from(entity, component_id);
+        } else {
+            component_manager->template remove_component_from<Component>(entity);
+        }
+
+        system_manager->on_remove_component(entity, component_id);
+    }
+
+    template <typename Component>
+    ComponentID get_component_id() {
+        return component_manager->template get_component_id<Component>();
+    }
+
+    template <typename Component>
+    bool has_component(Entity entity) {
+        return entity_manager->is_alive(entity)
+            && entity_manager->get_signature(entity).test(get_component_id<Component>());
+    }
+
     template <typename Component>
     Component &get_component(Entity entity) {
+        check_alive(entity);
+
+        if (storage == Storage::Archetype) {
+            auto component_id = component_manager->template get_component_id<Component>();
+            return archetype_manager->template get_component<Component>(entity, component_id);
+        }
+
         return component_manager->template get_component<Component>(entity);
     }
 
+    // Iterate over every entity that has all of `Components`. Requires
+    // `Storage::Sparse`; use `for_each` to iterate regardless of storage.
+    template <typename... Components>
+        requires (sizeof...(Components) > 0)
+    View<Max_Components, Components...> view() {
+        if (storage != Storage::Sparse) {
+            throw std::runtime_error("view requires sparse storage");
+        }
+
+        return View<Max_Components, Components...>(
+            component_manager->template get_array<Components>()...,
+            entity_manager.get(),
+            { component_manager->template get_component_id<Components>()... });
+    }
+
+    // Call `fn(entity, components&...)` for every entity that has all of `Components`.
+    // With `Storage::Archetype` this walks the matching chunks directly, otherwise it
+    // iterates a `view`.
+    template <typename... Components, typename Fn>
+    void for_each(Fn &&fn) {
+        if (storage == Storage::Archetype) {
+            archetype_manager->template for_each<Components...>(
+                { component_manager->template get_component_id<Components>()... },
+                std::forward<Fn>(fn));
+        } else {
+            view<Components...>().each(std::forward<Fn>(fn));
+        }
+    }
+
+    // Call `fn(entity, components&...)` for every entity that has all of `Components`,
+    // spreading the entities over `pool` in cache-line-aligned chunks. Returns once
+    // every entity has been visited. Per-thread scratch space can be kept in a
+    // `PerThread` created for the same pool. `fn` must not throw, add or remove
+    // components, or create or delete entities.
+    template <typename... Components, typename Fn>
+    void parallel_for_each(ThreadPool &pool, Fn &&fn) {
+        if (storage == Storage::Archetype) {
+            archetype_manager->template parallel_for_each<Components...>(pool,
+                { component_manager->template get_component_id<Components>()... }, fn);
+        } else {
+            auto components = view<Components...>();
+            parallel_for(pool, components.candidates(), [&components, &fn](std::size_t begin, std::size_t end) {
+                components.each(begin, end, fn);
+            });
+        }
+    }
+
+    // `parallel_for_each` on the manager's own thread pool
+    template <typename... Components, typename Fn>
+    void parallel_for_each(Fn &&fn) {
+        parallel_for_each<Components...>(*thread_pool, std::forward<Fn>(fn));
+    }
+
+    // Memory used by each registered component type in the active storage
+    std::vector<ComponentMemoryUsage> component_memory_usage() const {
+        if (storage == Storage::Archetype) {
+            return archetype_manager->memory_usage();
+        }
+
+        return component_manager->memory_usage();
+    }
+
+    // Bytes allocated for tracking entities, independent of their components
+    std::size_t entity_memory_usage() const {
+        return entity_manager->allocated_bytes();
+    }
+
+    Storage get_storage() const noexcept {
+        return storage;
+    }
+
+    // Deferred structural changes
+
+    // The calling thread's command buffer. Entity creation and deletion and component
+    // addition and removal may not run concurrently with systems or parallel loops,
+    // so code running on the thread pool records them here instead.
+    CommandBuffer &commands() noexcept {
+        return command_queue->local();
+    }
+
+    // Apply every command recorded since the last flush. Must be called from the
+    // thread driving the ECS while no systems are running.
+    void flush_commands() {
+        command_queue->play_back(*this);
+    }
+
     // Events
     void broadcast(const Event &event) {
         event_manager->broadcast(event);
     }
 
+    template <StaticEvent E>
+    void broadcast(const E &event) {
+        event_manager->broadcast(event);
+    }
+
+    // Queue an event to be delivered at the start of the next `run_systems`
+    void enqueue(const Event &event) {
+        event_manager->enqueue(event);
+    }
+
+    template <StaticEvent E>
+    void enqueue(const E &event) {
+        event_manager->enqueue(event);
+    }
+
+    // Queue an event from any thread, see `EventManager::post`
+    bool post(const Event &event) {
+        return event_manager->post(event);
+    }
+
+    template <StaticEvent E>
+    bool post(const E &event) {
+        return event_manager->post(event);
+    }
+
     // Assets
     template <typename Asset>
     void register_asset() {
@@ -100,8 +331,73 @@ public:
     }
 
     template <typename Asset>
-    std::unordered_map<std::string, Asset> &get_all_assets() {
-        return asset_manager->template get_all_assets<Asset>();
+    Asset &get_asset(AssetHandle<Asset> handle) {
+        Asset *asset = asset_manager->get_asset(handle);
+        if (asset) {
+            return *asset;
+        } else {
+            throw std::runtime_error("Stale asset handle");
+        }
+    }
+
+    // The asset `handle` refers to, or null if it was removed or is still loading
+    template <typename Asset>
+    Asset *find_asset(AssetHandle<Asset> handle) {
+        return asset_manager->get_asset(handle);
+    }
+
+    template <typename Asset>
+    AssetHandle<Asset> get_asset_handle(std::string_view name) {
+        return asset_manager->template get_handle<Asset>(name);
+    }
+
+    template <typename Asset>
+    AssetHandle<Asset> get_asset_handle(AssetNameID id) {
+        return asset_manager->template get_handle<Asset>(id);
+    }
+
+    template <typename Asset>
+    void remove_asset(AssetHandle<Asset> handle) {
+        asset_manager->remove_asset(handle);
+    }
+
+    template <typename Asset, typename Fn>
+    void for_each_asset(Fn &&fn) {
+        asset_manager->template for_each_asset<Asset>(std::forward<Fn>(fn));
+    }
+
+    // Load `Asset` from `path` on the thread pool, see `AssetManager::load_async`. The
+    // asset becomes available from the `finalize_asset_loads` after it has been read.
+    template <typename Asset>
+    AssetLoad load_asset_async(const std::string &name, const std::string &path) {
+        return asset_manager->template load_async<Asset>(*thread_pool, name, path);
+    }
+
+    // Load every file under `directory` on the thread pool and wait for them, see
+    // `AssetManager::load_directory`
+    template <DirectoryLoadable Asset>
+    DirectoryLoadResult load_asset_directory(const std::string &directory, std::string_view extension = ".xml") {
+        return asset_manager->template load_directory<Asset>(*thread_pool, directory, extension);
+    }
+
+    void finalize_asset_loads() {
+        asset_manager->finalize_loads();
+    }
+
+    // Reload assets when the files they were loaded from change, see
+    // `AssetManager::enable_hot_reload`. Changes are picked up by `run_systems`.
+    void enable_asset_hot_reload(std::chrono::milliseconds debounce = std::chrono::milliseconds(150)) {
+        asset_manager->enable_hot_reload(debounce);
+    }
+
+    template <typename Asset>
+    AssetLoad get_asset_load(const std::string &name) {
+        return asset_manager->template get_load<Asset>(name);
+    }
+
+    template <typename Asset>
+    AssetState get_asset_state(const std::string &name) {
+        return asset_manager->template get_state<Asset>(name);
     }
 };
 
@@ -3,37 +3,77 @@
 
 namespace Calico {
 
+// Hands out `Entity` handles and tracks which components each entity has.
+//
+// Slots are allocated lazily, only growing the slot and signature tables when no
+// freed slot is available, up to the `Entity::Index_Mask` slots a handle can address.
+// Freed slots form an intrusive list threaded through the slot table: a free slot's
+// handle stores the index of the next free slot in place of its own index, along with
+// the generation its next occupant will get. A handle is therefore alive exactly when
+// it equals the handle stored in its slot.
 template <
-    std::size_t Max_Components,
-    std::size_t Max_Objects>
+    std::size_t Max_Components>
 class EntityManager {
 private:
-    std::array<std::bitset<Max_Components>, Max_Objects> signatures;
-    std::deque<Entity> unallocated_entities;
+    static constexpr std::uint32_t No_Free_Slot = Entity::Index_Mask;
+
+    std::vector<std::bitset<Max_Components>> signatures = {};
+    std::vector<Entity> slots = {};
+    std::uint32_t free_slot = No_Free_Slot;
 public:
-        EntityManager() {
-            for (Entity e = 0; e < Max_Objects; e++) {
-                unallocated_entities.push_back(e);
+    Entity new_entity() {
+        if (free_slot == No_Free_Slot) {
+            if (slots.size() == No_Free_Slot) {
+                throw std::runtime_error("Out of entities");
             }
+
+            slots.emplace_back(static_cast<std::uint32_t>(slots.size()), 0);
+            signatures.emplace_back();
+            return slots.back();
         }
 
-    Entity new_entity() {
-        Entity entity = unallocated_entities.front();
-        unallocated_entities.pop_front();
-        return entity;
+        std::uint32_t index = free_slot;
+        free_slot = slots[index].index();
+        slots[index] = Entity(index, slots[index].generation());
+        return slots[index];
     }
 
+    // Frees the slot of `entity`. Does nothing if `entity` isn't alive.
     void delete_entity(Entity e) {
-        signatures[e].reset();
-        unallocated_entities.push_front(e);
+        if (!is_alive(e)) {
+            return;
+        }
+
+        signatures[e.index()].reset();
+        slots[e.index()] = Entity(free_slot, e.generation() + 1);
+        free_slot = e.index();
+    }
+
+    // Make room for `n` entities without growing the tables again
+    void reserve(std::size_t n) {
+        slots.reserve(n);
+        signatures.reserve(n);
+    }
+
+    // Bytes allocated for the slot and signature tables
+    std::size_t allocated_bytes() const noexcept {
+        return slots.capacity() * sizeof(Entity) + signatures.capacity() * sizeof(std::bitset<Max_Components>);
+    }
+
+    bool is_alive(Entity e) const noexcept {
+        return e.index() < slots.size() && slots[e.index()] == e;
     }
 
     void add_component_to(Entity e, ComponentID id) {
-        signatures[e].set(id);
+        signatures[e.index()].set(id);
+    }
+
+    void remove_component_from(Entity e, ComponentID id) {
+        signatures[e.index()].reset(id);
     }
 
-    std::bitset<Max_Components> get_signature(Entity entity) {
-        return signatures[entity];
+    const std::bitset<Max_Components> &get_signature(Entity entity) const {
+        return signatures[entity.index()];
     }
 };
 
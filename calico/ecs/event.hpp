@@ -11,30 +11,96 @@ enum class EventType {
     MouseMoved,
 };
 
+// Base of statically typed events, which carry their data as members and are
+// delivered to listeners as themselves rather than wrapped in an `Event`:
+//
+//     struct MouseMovedEvent : TypedEvent<EventType::MouseMoved> { float x, y; };
+//
+// Typed events should be trivially copyable and fit in `Event::Payload_Bytes`, so that
+// they can also travel inside an `Event` when the type is only known at runtime.
+struct TypedEventBase {};
+
+template <EventType Type>
+struct TypedEvent : TypedEventBase {
+    static constexpr EventType type = Type;
+};
+
+template <typename E>
+concept StaticEvent = std::is_base_of_v<TypedEventBase, E>;
+
+struct KeyDownEvent : TypedEvent<EventType::KeyDown> {
+    int key = 0;
+};
+
+struct KeyUpEvent : TypedEvent<EventType::KeyUp> {
+    int key = 0;
+};
+
+struct QuitEvent : TypedEvent<EventType::Quit> {};
+
+struct MouseMovedEvent : TypedEvent<EventType::MouseMoved> {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// An event whose type is only known at runtime. The payload is stored inline, so
+// creating and copying events never allocates; in exchange it must be trivially
+// copyable and no larger than `Payload_Bytes`.
 struct Event {
+    static constexpr std::size_t Payload_Bytes = 32;
 private:
-    std::any data = {};
+    // Tag numbering payload types, see `TypeFamily`
+    struct PayloadFamily {};
+
+    static constexpr std::size_t No_Payload = std::numeric_limits<std::size_t>::max();
+
+    alignas(std::max_align_t) std::byte payload[Payload_Bytes] = {};
+    std::size_t payload_type = No_Payload;
+
+    template <typename T>
+    static std::size_t payload_id() noexcept {
+        return TypeFamily<PayloadFamily>::template id<T>();
+    }
 public:
     EventType type = {};
 
     Event() = delete;
     explicit Event(EventType type) : type(type) {}
 
+    // Wrap a typed event, which can then be read back with `get_if<E>()`
+    template <StaticEvent E>
+    explicit Event(const E &event) : type(E::type) {
+        set_param<E>(event);
+    }
+
     template <typename Type, typename... Args>
     Event &set_param(Args&&... args) {
-        data = Type(std::forward<Type>(args...));
+        static_assert(std::is_trivially_copyable_v<Type>, "Event payloads must be trivially copyable");
+        static_assert(sizeof(Type) <= Payload_Bytes, "Event payload too large, increase Event::Payload_Bytes");
+        static_assert(alignof(Type) <= alignof(std::max_align_t), "Event payload over-aligned");
+
+        new (payload) Type(std::forward<Args>(args)...);
+        payload_type = payload_id<Type>();
         return *this;
     }
 
+    // The payload if it is a `T`, otherwise null
     template <typename T>
-    std::optional<T> get_param() const {
-        try {
-            return std::any_cast<T>(data);
-        } catch(const std::bad_any_cast &e) {
-            /* log message */
-            // std::printf("Failed to cast param to %s\n", typeid(T).name());
-            return {};
+    const T *get_if() const noexcept {
+        if (payload_type != payload_id<T>()) {
+            return nullptr;
         }
+
+        return std::launder(reinterpret_cast<const T*>(payload));
+    }
+
+    template <typename T>
+    std::optional<T> get_param() const noexcept {
+        if (const T *param = get_if<T>()) {
+            return *param;
+        }
+
+        return std::nullopt;
     }
 };
 
@@ -1,33 +1,319 @@
 #ifndef _CALICO_EVENT_MANAGER_HPP_
 #define _CALICO_EVENT_MANAGER_HPP_
 
-#include <unordered_map>
-#include <list>
-
 #include "event.hpp"
 
 namespace Calico {
 
-#define EVENT_LISTENER(event, listener) event, std::bind(&listener, this, std::placeholders::_1)
+// Expands to the arguments of `add_listener` registering member function `listener`
+// of `this` for `event`, e.g. `manager.add_listener(EVENT_LISTENER(EventType::Quit, Game::on_quit))`
+#define EVENT_LISTENER(event, listener) event, ::Calico::delegate<&listener>(this)
+
+using EventHandler = Delegate<void(const Event&)>;
+
+template <typename E>
+using TypedEventHandler = Delegate<void(const E&)>;
 
-using EventHandler = std::function<void(const Event&)>;
+// Handler receiving every queued event of one type at once, see `EventManager::enqueue`
+template <typename E>
+using BatchEventHandler = Delegate<void(std::span<const E>)>;
 
+// Identifies a listener added to an `EventManager` so that it can be removed later.
+// Stays valid however many other listeners are added or removed.
+struct ListenerHandle {
+    enum class Kind : std::uint8_t {
+        Event,
+        Typed,
+        Batch,
+    };
+
+    Kind kind = Kind::Event;
+    // the `EventType` for `Event` listeners, otherwise the typed event's id
+    std::uint32_t list = 0;
+    std::uint32_t id = 0;
+};
+
+// Delivers events to listeners, either immediately through `broadcast` or in batches
+// through `enqueue` and `dispatch_queued`.
+//
+// Queued events are appended to a contiguous buffer per event type. `dispatch_queued`
+// swaps each buffer with a second, empty one before delivering what was queued, so
+// events queued by handlers during dispatch are delivered by the next call rather
+// than recursively.
+//
+// Other threads can hand events to the manager with `post`, which pushes them to a
+// lock-free queue that `dispatch_queued` drains on the thread driving the manager.
 class EventManager {
-    std::unordered_map<EventType, std::list<EventHandler>> event_handlers {};
 public:
-    inline void add_listener(const EventType type, EventHandler &&handler) {
-        event_handlers[type].push_back(handler);
+    // Number of posted events that can wait for `dispatch_queued` before `post` fails
+    static constexpr std::size_t Posted_Capacity = 4096;
+private:
+    // Handlers of one kind of event, called in the order they were added. Handlers may
+    // add and remove listeners while being called: added ones are called from the next
+    // event on, removed ones are skipped and erased once the outermost call returns.
+    template <typename Handler>
+    struct ListenerList {
+        struct Listener {
+            Handler handler = {};
+            std::uint32_t id = 0;
+        };
+
+        std::vector<Listener> listeners = {};
+        std::uint32_t next_id = 0;
+        std::uint32_t calling = 0;
+        bool has_removed = false;
+
+        std::uint32_t add(Handler handler) {
+            listeners.push_back({ handler, next_id });
+            return next_id++;
+        }
+
+        void remove(std::uint32_t id) {
+            auto listener = std::find_if(listeners.begin(), listeners.end(),
+                [id](const Listener &listener) { return listener.id == id; });
+            if (listener == listeners.end()) {
+                return;
+            }
+
+            if (calling > 0) {
+                listener->handler = {};
+                has_removed = true;
+            } else {
+                listeners.erase(listener);
+            }
+        }
+
+        template <typename Arg>
+        void call(const Arg &arg) {
+            calling++;
+
+            // indexed and copied out since handlers may add listeners, reallocating
+            std::size_t count = listeners.size();
+            for (std::size_t i = 0; i < count; i++) {
+                Handler handler = listeners[i].handler;
+                if (handler) {
+                    handler(arg);
+                }
+            }
+
+            if (--calling == 0 && has_removed) {
+                std::erase_if(listeners, [](const Listener &listener) { return !listener.handler; });
+                has_removed = false;
+            }
+        }
+    };
+
+    // Interface for the `TypedListeners` instantiated for each typed event
+    struct ITypedListeners {
+        virtual ~ITypedListeners() = default;
+        virtual void remove(ListenerHandle handle) = 0;
+        virtual void swap_queues() = 0;
+        virtual void dispatch_queued() = 0;
+    };
+
+    template <typename E>
+    struct TypedListeners final : public ITypedListeners {
+        ListenerList<TypedEventHandler<E>> handlers = {};
+        ListenerList<BatchEventHandler<E>> batch_handlers = {};
+        // events queued since the last dispatch, and the ones being dispatched
+        std::vector<E> queued = {};
+        std::vector<E> dispatching = {};
+
+        void remove(ListenerHandle handle) override {
+            if (handle.kind == ListenerHandle::Kind::Batch) {
+                batch_handlers.remove(handle.id);
+            } else {
+                handlers.remove(handle.id);
+            }
+        }
+
+        void swap_queues() override {
+            std::swap(queued, dispatching);
+        }
+
+        void dispatch_queued() override {
+            if (dispatching.empty()) {
+                return;
+            }
+
+            batch_handlers.call(std::span<const E>(dispatching));
+            for (const E &e : dispatching) {
+                handlers.call(e);
+            }
+
+            // keeps its capacity for the next frame
+            dispatching.clear();
+        }
+    };
+
+    // Tag numbering typed events, see `TypeFamily`
+    struct EventFamily {};
+
+    // Listeners of `Event`s, indexed by `EventType`
+    std::vector<ListenerList<EventHandler>> event_handlers = {};
+    // Listeners of typed events, indexed by the event type's id in `EventFamily`
+    std::vector<std::unique_ptr<ITypedListeners>> typed_handlers = {};
+    // queued `Event`s, double buffered like the typed queues
+    std::vector<Event> queued = {};
+    std::vector<Event> dispatching = {};
+
+    // An event posted from another thread, along with how to queue it once it
+    // reaches the thread driving the manager
+    struct PostedEvent {
+        Event event = Event(EventType::None);
+        void (*enqueue)(EventManager &manager, const Event &event) = nullptr;
+    };
+
+    std::unique_ptr<MPSCQueue<PostedEvent, Posted_Capacity>> posted =
+        std::make_unique<MPSCQueue<PostedEvent, Posted_Capacity>>();
+
+    template <typename E>
+    static std::size_t event_id() noexcept {
+        return TypeFamily<EventFamily>::template id<E>();
+    }
+
+    template <typename E>
+    TypedListeners<E> &listeners_of() {
+        std::size_t id = event_id<E>();
+        if (id >= typed_handlers.size()) {
+            typed_handlers.resize(id + 1);
+        }
+
+        if (!typed_handlers[id]) {
+            typed_handlers[id] = std::make_unique<TypedListeners<E>>();
+        }
+
+        return *static_cast<TypedListeners<E>*>(typed_handlers[id].get());
+    }
+public:
+    ListenerHandle add_listener(const EventType type, EventHandler handler) {
+        auto list = static_cast<std::size_t>(type);
+        if (list >= event_handlers.size()) {
+            event_handlers.resize(list + 1);
+        }
+
+        return {
+            .kind = ListenerHandle::Kind::Event,
+            .list = static_cast<std::uint32_t>(list),
+            .id = event_handlers[list].add(handler),
+        };
+    }
+
+    // Listen for `E` itself, e.g. `add_listener<MouseMovedEvent>(handler)`. Typed
+    // listeners are only called for typed events, not for `Event`s.
+    template <StaticEvent E>
+    ListenerHandle add_listener(TypedEventHandler<E> handler) {
+        return {
+            .kind = ListenerHandle::Kind::Typed,
+            .list = static_cast<std::uint32_t>(event_id<E>()),
+            .id = listeners_of<E>().handlers.add(handler),
+        };
+    }
+
+    // Listen for all the queued `E`s at once
+    template <StaticEvent E>
+    ListenerHandle add_batch_listener(BatchEventHandler<E> handler) {
+        return {
+            .kind = ListenerHandle::Kind::Batch,
+            .list = static_cast<std::uint32_t>(event_id<E>()),
+            .id = listeners_of<E>().batch_handlers.add(handler),
+        };
     }
 
-    void broadcast(const Event &e) const {
-        if (!event_handlers.contains(e.type)) {
-            return;
+    // Stop calling the listener `handle` was returned for. Removing a listener twice
+    // does nothing.
+    void remove_listener(ListenerHandle handle) {
+        if (handle.kind == ListenerHandle::Kind::Event) {
+            if (handle.list < event_handlers.size()) {
+                event_handlers[handle.list].remove(handle.id);
+            }
+        } else if (handle.list < typed_handlers.size() && typed_handlers[handle.list]) {
+            typed_handlers[handle.list]->remove(handle);
         }
+    }
+
+    void broadcast(const Event &e) {
+        auto list = static_cast<std::size_t>(e.type);
+        if (list < event_handlers.size()) {
+            event_handlers[list].call(e);
+        }
+    }
 
-        for (const auto &handler : event_handlers.at(e.type)) {
-            handler(e);
+    // Deliver `e` to the listeners of `E` directly, without wrapping it in an `Event`
+    template <StaticEvent E>
+    void broadcast(const E &e) {
+        std::size_t id = event_id<E>();
+        if (id < typed_handlers.size() && typed_handlers[id]) {
+            static_cast<TypedListeners<E>*>(typed_handlers[id].get())->handlers.call(e);
         }
     }
+
+    // Queue `e` to be delivered by the next `dispatch_queued`
+    void enqueue(const Event &e) {
+        queued.push_back(e);
+    }
+
+    template <StaticEvent E>
+    void enqueue(const E &e) {
+        listeners_of<E>().queued.push_back(e);
+    }
+
+    // Queue `e` from any thread. Returns false and drops the event if `Posted_Capacity`
+    // events are already waiting to be drained.
+    bool post(const Event &e) {
+        return posted->try_push({
+            .event = e,
+            .enqueue = [](EventManager &manager, const Event &event) {
+                manager.enqueue(event);
+            },
+        });
+    }
+
+    template <StaticEvent E>
+    bool post(const E &e) {
+        return posted->try_push({
+            .event = Event(e),
+            .enqueue = [](EventManager &manager, const Event &event) {
+                manager.enqueue(*event.get_if<E>());
+            },
+        });
+    }
+
+    // Counters of the queue behind `post`
+    QueueStats posted_stats() const noexcept {
+        return posted->stats();
+    }
+
+    // Deliver every event queued or posted since the last call. Typed events are
+    // delivered grouped by type, first to batch listeners and then to per-event
+    // listeners, followed by `Event`s in the order they were queued.
+    void dispatch_queued() {
+        PostedEvent e;
+        while (posted->try_pop(e)) {
+            e.enqueue(*this, e.event);
+        }
+
+        for (const auto &listeners : typed_handlers) {
+            if (listeners) {
+                listeners->swap_queues();
+            }
+        }
+
+        std::swap(queued, dispatching);
+
+        // handlers may register new event types, growing `typed_handlers`
+        for (std::size_t id = 0; id < typed_handlers.size(); id++) {
+            if (typed_handlers[id]) {
+                typed_handlers[id]->dispatch_queued();
+            }
+        }
+
+        for (const Event &e : dispatching) {
+            broadcast(e);
+        }
+
+        dispatching.clear();
+    }
 };
 
 }
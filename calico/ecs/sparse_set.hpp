@@ -0,0 +1,120 @@
+#ifndef _CALICO_SPARSE_SET_HPP_
+#define _CALICO_SPARSE_SET_HPP_
+
+namespace Calico {
+
+// Maps `Entity` handles to slots in a densely packed array without hashing.
+//
+// The sparse side is a table indexed directly by entity index, split into fixed-size
+// pages that are only allocated once an entity falling inside them is inserted, so a
+// few entities with large ids don't cost a table covering every possible entity. The
+// dense side lists the entities in insertion order and is kept parallel to whatever
+// array the owner stores its data in, so lookup, insertion and swap-removal are all
+// plain array indexing.
+template <
+    std::size_t Page_Size = 4096>
+class SparseSet {
+    static constexpr Index Tombstone = std::numeric_limits<Index>::max();
+
+    static_assert(Entity::Index_Mask < Tombstone, "Index type too small to address every entity");
+
+    using Page = std::array<Index, Page_Size>;
+
+    std::vector<std::unique_ptr<Page>> pages = {};
+    std::vector<Entity> dense = {};
+
+    Index &sparse_slot(Entity entity) {
+        std::size_t page_index = entity.index() / Page_Size;
+        if (page_index >= pages.size()) {
+            pages.resize(page_index + 1);
+        }
+
+        auto &page = pages[page_index];
+        if (!page) {
+            page = std::make_unique<Page>();
+            page->fill(Tombstone);
+        }
+
+        return (*page)[entity.index() % Page_Size];
+    }
+public:
+    // Whether `entity` is in the set. Since the dense array stores whole handles, a
+    // stale handle to an earlier occupant of an entity's slot is rejected too.
+    bool contains(Entity entity) const noexcept {
+        std::size_t page_index = entity.index() / Page_Size;
+        if (page_index >= pages.size() || !pages[page_index]) {
+            return false;
+        }
+
+        Index index = (*pages[page_index])[entity.index() % Page_Size];
+        return index != Tombstone && dense[index] == entity;
+    }
+
+    // Position of `entity` in the dense array. `entity` must be in the set.
+    Index index_of(Entity entity) const noexcept {
+        return (*pages[entity.index() / Page_Size])[entity.index() % Page_Size];
+    }
+
+    // Appends `entity` to the dense array and returns its position
+    Index insert(Entity entity) {
+        Index index = static_cast<Index>(dense.size());
+        sparse_slot(entity) = index;
+        dense.push_back(entity);
+        return index;
+    }
+
+    // Removes `entity` by moving the last entity in the dense array into its slot.
+    // Returns the slot that was vacated so that owners of a parallel array can mirror
+    // the swap. `entity` must be in the set.
+    Index erase(Entity entity) {
+        Index index = index_of(entity);
+        Entity last = dense.back();
+
+        dense[index] = last;
+        sparse_slot(last) = index;
+        sparse_slot(entity) = Tombstone;
+        dense.pop_back();
+
+        return index;
+    }
+
+    // Bytes allocated for the sparse pages and the dense array
+    std::size_t allocated_bytes() const noexcept {
+        std::size_t bytes = pages.capacity() * sizeof(std::unique_ptr<Page>) + dense.capacity() * sizeof(Entity);
+        for (const auto &page : pages) {
+            if (page) {
+                bytes += sizeof(Page);
+            }
+        }
+
+        return bytes;
+    }
+
+    void reserve(std::size_t n) {
+        dense.reserve(n);
+    }
+
+    std::size_t size() const noexcept {
+        return dense.size();
+    }
+
+    bool empty() const noexcept {
+        return dense.empty();
+    }
+
+    const Entity *data() const noexcept {
+        return dense.data();
+    }
+
+    auto begin() const noexcept {
+        return dense.begin();
+    }
+
+    auto end() const noexcept {
+        return dense.end();
+    }
+};
+
+}
+
+#endif // _CALICO_SPARSE_SET_HPP_
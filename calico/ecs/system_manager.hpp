@@ -1,28 +1,52 @@
 #ifndef _CALICO_SYSTEM_MANAGER_HPP_
 #define _CALICO_SYSTEM_MANAGER_HPP_
 
+#include <atomic>
 #include <bitset>
+#include <exception>
 #include <memory>
-#include <set>
-#include <typeinfo>
-#include <typeindex>
-#include <unordered_map>
+#include <mutex>
+#include <vector>
 
 namespace Calico {
 
 class ECSManager;
 
+// How a system uses a component in its signature. Systems whose accesses don't
+// conflict may be run at the same time by `SystemManager::run`.
+enum class Access {
+    Read,
+    Write,
+};
+
 class System {
 protected:
-    std::set<Entity> entities = {};
+    // Entities whose signature contains every component the system requires. Kept up
+    // to date by the `SystemManager` as components are added and removed and entities
+    // are deleted. A system requiring no components gets every entity given one.
+    SparseSet<> entities = {};
     ECSManager *ecs;
 public:
     System(ECSManager *ecs) : ecs(ecs) {}
+    virtual ~System() = default;
 
     virtual void init_events(EventManager &manager) = 0;
 
+    // Called once per frame by `ECSManager::run_systems`, possibly on a worker thread
+    // and concurrently with other systems. Only the components declared through
+    // `add_system_signature` may be accessed, and only in the declared way.
+    virtual void update(float) {}
+
     void add_entity(Entity entity) {
-        entities.insert(entity);
+        if (!entities.contains(entity)) {
+            entities.insert(entity);
+        }
+    }
+
+    void remove_entity(Entity entity) {
+        if (entities.contains(entity)) {
+            entities.erase(entity);
+        }
     }
 };
 
@@ -30,28 +54,203 @@ template <
     std::size_t Max_Components>
 class SystemManager {
 private:
-    std::unordered_map<std::type_index, std::shared_ptr<System>> systems = {};
-    std::unordered_map<std::shared_ptr<System>, std::bitset<Max_Components>> signatures = {};
+    // A system in the dependency graph used to schedule systems across threads. Nodes
+    // are kept in registration order, and a system depends on every earlier system
+    // it conflicts with, so conflicting systems always run in registration order.
+    struct Node {
+        std::shared_ptr<System> system = {};
+        std::bitset<Max_Components> signature = {};
+        std::bitset<Max_Components> reads = {};
+        std::bitset<Max_Components> writes = {};
+        std::vector<std::size_t> dependents = {};
+        std::size_t dependencies = 0;
+    };
+
+    struct Frame {
+        float dt = 0.f;
+        std::atomic<std::size_t> pending = 0;
+        std::mutex error_mutex;
+        std::exception_ptr error = nullptr;
+    };
+
+    // Tag numbering system types, see `TypeFamily`
+    struct SystemFamily {};
+
+    static constexpr std::size_t No_Node = std::numeric_limits<std::size_t>::max();
+
+    std::vector<Node> nodes = {};
+    // index into `nodes` of each system type, indexed by the type's `SystemFamily` id
+    std::vector<std::size_t> node_index = {};
+    // nodes whose signature contains each component, so that a change to one bit of
+    // an entity's signature only visits the systems that care about that bit
+    std::array<std::vector<std::size_t>, Max_Components> nodes_by_component = {};
+    // nodes with an empty signature, which match every entity with a component
+    std::vector<std::size_t> unfiltered_nodes = {};
+    std::unique_ptr<std::atomic<std::size_t>[]> remaining_dependencies = {};
+    bool graph_dirty = true;
+
+    // Systems which declared no components might touch anything, so they conflict
+    // with every other system
+    static bool conflicts(const Node &a, const Node &b) {
+        if ((a.reads | a.writes).none() || (b.reads | b.writes).none()) {
+            return true;
+        }
+
+        return (a.writes & (b.reads | b.writes)).any() || (b.writes & a.reads).any();
+    }
+
+    void build_graph() {
+        for (auto &node : nodes) {
+            node.dependents.clear();
+            node.dependencies = 0;
+        }
+
+        for (std::size_t later = 0; later < nodes.size(); later++) {
+            for (std::size_t earlier = 0; earlier < later; earlier++) {
+                if (conflicts(nodes[earlier], nodes[later])) {
+                    nodes[earlier].dependents.push_back(later);
+                    nodes[later].dependencies++;
+                }
+            }
+        }
+
+        remaining_dependencies = std::make_unique<std::atomic<std::size_t>[]>(nodes.size());
+        graph_dirty = false;
+    }
+
+    void launch(ThreadPool &pool, Frame &frame, std::size_t index) {
+        pool.submit([this, &pool, &frame, index] {
+            try {
+                nodes[index].system->update(frame.dt);
+            } catch (...) {
+                std::lock_guard lock(frame.error_mutex);
+                if (!frame.error) {
+                    frame.error = std::current_exception();
+                }
+            }
+
+            for (std::size_t dependent : nodes[index].dependents) {
+                if (remaining_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    launch(pool, frame, dependent);
+                }
+            }
+
+            frame.pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    template <typename T>
+    std::size_t &node_of() {
+        std::size_t id = TypeFamily<SystemFamily>::template id<T>();
+        if (id >= node_index.size()) {
+            node_index.resize(id + 1, No_Node);
+        }
+
+        return node_index[id];
+    }
 public:
     template <typename T>
     std::shared_ptr<T> register_system(ECSManager *ecs) {
+        auto &index = node_of<T>();
+        if (index != No_Node) {
+            throw std::runtime_error("System already registered to manager");
+        }
+
         auto system = std::make_shared<T>(ecs);
-        systems.insert({ std::type_index(typeid(T)), system });
-        signatures.insert({ system, {}});
+        index = nodes.size();
+        nodes.push_back({ .system = system });
+        unfiltered_nodes.push_back(index);
+        graph_dirty = true;
         return system;
     }
 
     template <typename T>
-    void add_signature(ComponentID id) {
-        signatures[systems[std::type_index(typeid(T))]].set(id);
+    void add_signature(ComponentID id, Access access = Access::Write) {
+        std::size_t index = node_of<T>();
+        if (index == No_Node) {
+            throw std::runtime_error("System not registered to manager");
+        }
+
+        auto &node = nodes[index];
+        if (node.signature.none()) {
+            std::erase(unfiltered_nodes, index);
+        }
+
+        if (!node.signature.test(id)) {
+            node.signature.set(id);
+            nodes_by_component[id].push_back(index);
+        }
+
+        if (access == Access::Write) {
+            node.writes.set(id);
+        } else {
+            node.reads.set(id);
+        }
+
+        graph_dirty = true;
     }
 
-    void on_add_component(Entity entity, std::bitset<Max_Components> new_signature) {
-        for (auto &[index, system] : systems) {
-            if ((signatures.at(system) & new_signature) == signatures.at(system)) {
-                system->add_entity(entity);
+    // Called after component `id` was added to `entity`, giving it `new_signature`
+    void on_add_component(Entity entity, ComponentID id, const std::bitset<Max_Components> &new_signature) {
+        for (std::size_t index : nodes_by_component[id]) {
+            const auto &signature = nodes[index].signature;
+            if ((signature & new_signature) == signature) {
+                nodes[index].system->add_entity(entity);
             }
         }
+
+        for (std::size_t index : unfiltered_nodes) {
+            nodes[index].system->add_entity(entity);
+        }
+    }
+
+    // Called after component `id` was removed from `entity`
+    void on_remove_component(Entity entity, ComponentID id) {
+        for (std::size_t index : nodes_by_component[id]) {
+            nodes[index].system->remove_entity(entity);
+        }
+    }
+
+    // Called before `entity`, whose signature is `signature`, is deleted
+    void on_entity_destroyed(Entity entity, const std::bitset<Max_Components> &signature) {
+        for (std::size_t id = 0; id < Max_Components; id++) {
+            if (signature.test(id)) {
+                on_remove_component(entity, static_cast<ComponentID>(id));
+            }
+        }
+
+        for (std::size_t index : unfiltered_nodes) {
+            nodes[index].system->remove_entity(entity);
+        }
+    }
+
+    // Update every system once. Each system starts as soon as all earlier systems it
+    // conflicts with have finished, and the call returns once every system has run,
+    // rethrowing the first exception thrown by a system.
+    void run(ThreadPool &pool, float dt) {
+        if (graph_dirty) {
+            build_graph();
+        }
+
+        Frame frame;
+        frame.dt = dt;
+        frame.pending = nodes.size();
+
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            remaining_dependencies[i].store(nodes[i].dependencies, std::memory_order_relaxed);
+        }
+
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].dependencies == 0) {
+                launch(pool, frame, i);
+            }
+        }
+
+        pool.wait(frame.pending);
+
+        if (frame.error) {
+            std::rethrow_exception(frame.error);
+        }
     }
 };
 
@@ -0,0 +1,120 @@
+#ifndef _CALICO_VIEW_HPP_
+#define _CALICO_VIEW_HPP_
+
+namespace Calico {
+
+// Iterates over every entity that has all of `Components`, yielding
+// `(Entity, Components&...)` tuples:
+//
+//     for (auto [entity, transform, velocity] : ecs.view<Transform, Velocity>()) {
+//         ...
+//     }
+//
+// Iteration is driven by the smallest `ComponentArray` among `Components`, so the
+// number of candidates is bounded by the rarest component. Candidates whose signature
+// doesn't contain every component are skipped with a bitset test, and the remaining
+// components are fetched through their arrays' sparse sets.
+//
+// Adding or removing any of `Components` while iterating invalidates the view.
+template <
+    std::size_t Max_Components,
+    typename... Components>
+class View {
+    template <typename C>
+    using Array = typename ComponentManager<Max_Components>::template ComponentArray<C>;
+
+    using Signatures = EntityManager<Max_Components>;
+
+    std::tuple<Array<Components>*...> arrays;
+    const Signatures *signatures = nullptr;
+    std::bitset<Max_Components> mask = {};
+    const Entity *first = nullptr;
+    const Entity *last = nullptr;
+
+    bool matches(Entity entity) const {
+        return (signatures->get_signature(entity) & mask) == mask;
+    }
+
+    std::tuple<Entity, Components&...> fetch(Entity entity) const {
+        return { entity, std::get<Array<Components>*>(arrays)->get_component(entity)... };
+    }
+public:
+    class Iterator {
+        const View *view = nullptr;
+        const Entity *current = nullptr;
+
+        void skip_mismatches() {
+            while (current != view->last && !view->matches(*current)) {
+                current++;
+            }
+        }
+    public:
+        Iterator(const View *view, const Entity *current) : view(view), current(current) {
+            skip_mismatches();
+        }
+
+        std::tuple<Entity, Components&...> operator*() const {
+            return view->fetch(*current);
+        }
+
+        Iterator &operator++() {
+            current++;
+            skip_mismatches();
+            return *this;
+        }
+
+        bool operator==(const Iterator &rhs) const {
+            return current == rhs.current;
+        }
+    };
+
+    View(Array<Components>*... component_arrays, const Signatures *signatures,
+            const std::array<ComponentID, sizeof...(Components)> &ids)
+        : arrays(component_arrays...), signatures(signatures) {
+        for (ComponentID id : ids) {
+            mask.set(id);
+        }
+
+        const SparseSet<> *smallest = nullptr;
+        ((smallest = (!smallest || component_arrays->size() < smallest->size())
+            ? &component_arrays->get_entities() : smallest), ...);
+
+        first = smallest->data();
+        last = first + smallest->size();
+    }
+
+    Iterator begin() const {
+        return Iterator(this, first);
+    }
+
+    Iterator end() const {
+        return Iterator(this, last);
+    }
+
+    // Call `fn(entity, components&...)` for every matching entity
+    template <typename Fn>
+    void each(Fn &&fn) const {
+        each(0, candidates(), fn);
+    }
+
+    // Call `fn(entity, components&...)` for the matching entities among candidates
+    // `[begin, end)`. Disjoint ranges may be iterated from different threads.
+    template <typename Fn>
+    void each(std::size_t begin, std::size_t end, Fn &&fn) const {
+        for (const Entity *entity = first + begin; entity != first + end; entity++) {
+            if (matches(*entity)) {
+                std::apply(fn, fetch(*entity));
+            }
+        }
+    }
+
+    // Number of entities in the array driving the iteration, an upper bound on the
+    // number of matches
+    std::size_t candidates() const noexcept {
+        return static_cast<std::size_t>(last - first);
+    }
+};
+
+}
+
+#endif // _CALICO_VIEW_HPP_
@@ -0,0 +1,142 @@
+#ifndef __CALICO_GL_BLOCK_LAYOUT_HPP__
+#define __CALICO_GL_BLOCK_LAYOUT_HPP__
+
+namespace Calico::OpenGL {
+
+// Packing rules of GLSL interface blocks. Uniform blocks use `Std140`; `Std430`, which
+// doesn't round arrays up to vec4 strides, is for shader storage blocks.
+enum class BlockLayout {
+    Std140,
+    Std430,
+};
+
+// Alignment and size of a C++ type as a block member, and how to copy it into the
+// block. Scalars are 4 bytes, bools included; a vec3 is 12 bytes aligned to 16, so a
+// following scalar fills its last 4 bytes; matrices are arrays of column vectors.
+template <BlockLayout Layout, typename T>
+struct BlockMember {
+    static_assert(!sizeof(T), "Unsupported uniform block member type");
+};
+
+template <BlockLayout Layout, typename T>
+    requires (std::is_same_v<T, float> || std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint32_t>)
+struct BlockMember<Layout, T> {
+    static constexpr std::size_t alignment = 4;
+    static constexpr std::size_t size = 4;
+
+    static void write(std::byte *dst, const T &value) {
+        std::memcpy(dst, &value, size);
+    }
+};
+
+template <BlockLayout Layout>
+struct BlockMember<Layout, bool> {
+    static constexpr std::size_t alignment = 4;
+    static constexpr std::size_t size = 4;
+
+    static void write(std::byte *dst, const bool &value) {
+        std::uint32_t word = value ? 1 : 0;
+        std::memcpy(dst, &word, size);
+    }
+};
+
+template <BlockLayout Layout, typename T>
+    requires (std::is_same_v<T, glm::vec2> || std::is_same_v<T, glm::vec3> || std::is_same_v<T, glm::vec4>)
+struct BlockMember<Layout, T> {
+    static constexpr std::size_t alignment = sizeof(T) == 8 ? 8 : 16;
+    static constexpr std::size_t size = sizeof(T);
+
+    static void write(std::byte *dst, const T &value) {
+        std::memcpy(dst, &value, size);
+    }
+};
+
+template <BlockLayout Layout>
+struct BlockMember<Layout, glm::mat4> {
+    static constexpr std::size_t alignment = 16;
+    static constexpr std::size_t size = 64;
+
+    static void write(std::byte *dst, const glm::mat4 &value) {
+        std::memcpy(dst, glm::value_ptr(value), size);
+    }
+};
+
+// three vec3 columns, each padded to 16 bytes
+template <BlockLayout Layout>
+struct BlockMember<Layout, glm::mat3> {
+    static constexpr std::size_t alignment = 16;
+    static constexpr std::size_t size = 48;
+
+    static void write(std::byte *dst, const glm::mat3 &value) {
+        const float *columns = glm::value_ptr(value);
+        for (std::size_t column = 0; column < 3; column++) {
+            std::memcpy(dst + column * 16, columns + column * 3, 3 * sizeof(float));
+        }
+    }
+};
+
+// std140 rounds the alignment and stride of array elements up to a vec4's
+template <BlockLayout Layout, typename T, std::size_t N>
+struct BlockMember<Layout, std::array<T, N>> {
+    using Element = BlockMember<Layout, T>;
+
+    static constexpr std::size_t alignment = Layout == BlockLayout::Std140
+        ? (Element::alignment + 15) / 16 * 16 : Element::alignment;
+    static constexpr std::size_t stride = (Element::size + alignment - 1) / alignment * alignment;
+    static constexpr std::size_t size = stride * N;
+
+    static void write(std::byte *dst, const std::array<T, N> &value) {
+        for (std::size_t i = 0; i < N; i++) {
+            Element::write(dst + i * stride, value[i]);
+        }
+    }
+};
+
+// Offsets of the members `Types` of a block in declaration order, and the size of the
+// block, computed at compile time. `Member<I>` is the type of member `I`.
+template <BlockLayout Layout, typename... Types>
+struct BlockLayoutOf {
+    static constexpr std::size_t count = sizeof...(Types);
+    static constexpr std::array<std::size_t, count> alignments = { BlockMember<Layout, Types>::alignment... };
+    static constexpr std::array<std::size_t, count> sizes = { BlockMember<Layout, Types>::size... };
+
+    template <std::size_t I>
+    using Member = std::tuple_element_t<I, std::tuple<Types...>>;
+
+    static constexpr std::array<std::size_t, count> offsets = [] {
+        std::array<std::size_t, count> result = {};
+        std::size_t end = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            result[i] = (end + alignments[i] - 1) / alignments[i] * alignments[i];
+            end = result[i] + sizes[i];
+        }
+
+        return result;
+    }();
+
+    // std140 blocks are padded like a struct, to a multiple of a vec4
+    static constexpr std::size_t size = [] {
+        std::size_t end = count > 0 ? offsets[count - 1] + sizes[count - 1] : 0;
+        std::size_t alignment = Layout == BlockLayout::Std140 ? 16 : 4;
+        for (std::size_t member : alignments) {
+            alignment = member > alignment ? member : alignment;
+        }
+
+        return (end + alignment - 1) / alignment * alignment;
+    }();
+
+    template <std::size_t I>
+    static void write(std::byte *block, const Member<I> &value) {
+        BlockMember<Layout, Member<I>>::write(block + offsets[I], value);
+    }
+};
+
+template <typename... Types>
+using Std140 = BlockLayoutOf<BlockLayout::Std140, Types...>;
+
+template <typename... Types>
+using Std430 = BlockLayoutOf<BlockLayout::Std430, Types...>;
+
+}
+
+#endif // __CALICO_GL_BLOCK_LAYOUT_HPP__
@@ -0,0 +1,142 @@
+#ifndef __CALICO_GL_INSTANCE_BATCHER_HPP__
+#define __CALICO_GL_INSTANCE_BATCHER_HPP__
+
+namespace Calico::OpenGL {
+
+// Component drawing `mesh` with `program` once per entity, through an `InstanceBatcher`.
+// The mesh needs an instance layout matching the batcher's `Instance`.
+struct InstancedMesh {
+    IVertexArray *mesh = nullptr;
+    Program *program = nullptr;
+    std::uint16_t material = 0;
+};
+
+// What the last `InstanceBatcher::draw` sent to GL
+struct InstanceBatcherStats {
+    std::size_t draws = 0;
+    std::size_t instances = 0;
+};
+
+// Groups the instances of each mesh, program and material combination so each group
+// is drawn with one upload and one `draw_instanced`, instead of a uniform upload and a
+// draw for every copy.
+//
+// `Instance` is the per-instance data, laid out as the meshes' instance layout, e.g.
+// a `glm::mat4` model matrix for meshes with `set_instance_layout<glm::mat4>()`. Groups
+// are kept between frames with their buffers, so a steady scene stops allocating.
+template <typename Instance>
+class InstanceBatcher {
+    struct BatchKey {
+        IVertexArray *mesh;
+        Program *program;
+        std::uint16_t material;
+
+        bool operator==(const BatchKey &rhs) const noexcept = default;
+    };
+
+    struct BatchKeyHash {
+        std::size_t operator()(const BatchKey &key) const noexcept {
+            std::size_t hash = std::hash<IVertexArray*>{}(key.mesh);
+            hash ^= std::hash<Program*>{}(key.program) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+            return hash ^ (key.material + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    struct Batch {
+        BatchKey key;
+        std::vector<Instance> instances;
+    };
+
+    std::unordered_map<BatchKey, std::size_t, BatchKeyHash> batch_indices = {};
+    std::vector<Batch> batches = {};
+    std::vector<std::pair<std::uint64_t, std::size_t>> order = {};
+    InstanceBatcherStats stats = {};
+
+    void draw_batches(StreamBuffer *stream, const RenderQueue::MaterialBinder &bind_material) {
+        order.clear();
+        for (std::size_t i = 0; i < batches.size(); i++) {
+            const auto &key = batches[i].key;
+            if (!batches[i].instances.empty()) {
+                order.emplace_back(DrawKey::make(*key.program, key.material, key.mesh->get_id(), 0.0f), i);
+            }
+        }
+
+        std::sort(order.begin(), order.end());
+
+        stats = {};
+        const Program *program = nullptr;
+        std::optional<std::uint16_t> material = std::nullopt;
+
+        for (const auto &[draw_key, index] : order) {
+            auto &batch = batches[index];
+
+            if (batch.key.program != program || batch.key.material != material) {
+                program = batch.key.program;
+                material = batch.key.material;
+                if (bind_material) {
+                    StateCache::get().use_program(*batch.key.program);
+                    bind_material(*batch.key.program, batch.key.material);
+                }
+            }
+
+            // a mesh shared by several groups gets each one's data right before its draw
+            auto &instances = batch.instances;
+            if (stream != nullptr) {
+                batch.key.mesh->set_instance_data(*stream, instances.data(), instances.size() * sizeof(Instance), instances.size());
+            } else {
+                batch.key.mesh->set_instance_data(instances.data(), instances.size() * sizeof(Instance), instances.size());
+            }
+            batch.key.mesh->draw_instanced(*batch.key.program, instances.size());
+
+            stats.draws++;
+            stats.instances += instances.size();
+            instances.clear();
+        }
+    }
+public:
+    void add(IVertexArray &mesh, Program &program, std::uint16_t material, const Instance &instance) {
+        BatchKey key = { &mesh, &program, material };
+        auto [it, inserted] = batch_indices.try_emplace(key, batches.size());
+        if (inserted) {
+            batches.push_back({ key, {} });
+        }
+
+        batches[it->second].instances.push_back(instance);
+    }
+
+    // Add every entity of `ecs` with an `InstancedMesh` and a `Transform`, with the
+    // instance `to_instance(transform)` returns
+    template <typename Transform, typename ECS, typename Fn>
+    void gather(ECS &ecs, Fn &&to_instance) {
+        ecs.template for_each<InstancedMesh, Transform>([this, &to_instance](auto, InstancedMesh &instanced, Transform &transform) {
+            add(*instanced.mesh, *instanced.program, instanced.material, to_instance(transform));
+        });
+    }
+
+    // Upload and draw every group added since the last draw, ordered by program,
+    // material and mesh, then empty the groups. `bind_material` is called like the
+    // `RenderQueue`'s, when the draws switch to another material.
+    void draw(const RenderQueue::MaterialBinder &bind_material = {}) {
+        draw_batches(nullptr, bind_material);
+    }
+
+    // Like `draw`, but the instances are written to this frame's region of `stream`
+    // rather than uploaded to each mesh's instance buffer
+    void draw(StreamBuffer &stream, const RenderQueue::MaterialBinder &bind_material = {}) {
+        draw_batches(&stream, bind_material);
+    }
+
+    // Forget every group, e.g. after meshes or programs were deleted
+    void clear() {
+        batch_indices.clear();
+        batches.clear();
+    }
+
+    const InstanceBatcherStats &get_stats() const noexcept {
+        return stats;
+    }
+};
+
+}
+
+#endif // __CALICO_GL_INSTANCE_BATCHER_HPP__
@@ -82,33 +82,27 @@ public:
     // error for a shader to not use a specific global. Therefore this
     // returns a bool to denote success or failure which allows the program
     // to then decide if this is an error or not.
+    //
+    // Leaves the program in use, see `StateCache`.
     bool set_uniform_mat4(const char *name, glm::mat4 matrix) {
-        GLCALL(glUseProgram(program_id));
-
         auto uniform_id = get_uniform(name);
-        if (uniform_id) {
-            glUniformMatrix4fv(uniform_id.value(), 1, GL_FALSE, glm::value_ptr(matrix));
-        } else {
-            GLCALL(glUseProgram(0));
+        if (!uniform_id) {
             return false;
         }
 
-        GLCALL(glUseProgram(0));
+        StateCache::get().use_program(program_id);
+        glUniformMatrix4fv(uniform_id.value(), 1, GL_FALSE, glm::value_ptr(matrix));
         return true;
     }
 
     bool set_uniform_float(const char *name, float x) {
-        GLCALL(glUseProgram(program_id));
-
         auto uniform_id = get_uniform(name);
-        if (uniform_id) {
-            glUniform1f(uniform_id.value(), x);
-        } else {
-            GLCALL(glUseProgram(0));
+        if (!uniform_id) {
             return false;
         }
 
-        GLCALL(glUseProgram(0));
+        StateCache::get().use_program(program_id);
+        glUniform1f(uniform_id.value(), x);
         return true;
     }
 
@@ -146,6 +140,7 @@ public:
 
     ~Program() {
         if (program_id > 0) {
+            StateCache::get().forget_program(program_id);
             glDeleteProgram(program_id);
         }
     }
@@ -0,0 +1,69 @@
+#ifndef _CALICO_GL_PROGRAM_LOADER_HPP_
+#define _CALICO_GL_PROGRAM_LOADER_HPP_
+
+#include "xml/parsers.hpp"
+
+namespace Calico {
+
+// Loads an `OpenGL::Program` from a program descriptor. The descriptor and the shader
+// sources it lists are read on a worker thread; compiling and linking happen in
+// `finalize` since they need the GL context.
+template <>
+struct AssetLoader<OpenGL::Program> {
+    struct Intermediate {
+        ProgramDescriptor descriptor = {};
+        std::vector<std::pair<ProgramDescriptor::ShaderType, std::string>> sources = {};
+        // shader files the sources were read from
+        std::vector<std::string> paths = {};
+    };
+
+    static std::string read_file(const std::filesystem::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Unable to open shader source '" + path.string() + "'");
+        }
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    static Intermediate load(const std::string &path) {
+        Intermediate data;
+        data.descriptor = XML::read_program(path);
+
+        // shader paths are relative to the descriptor
+        auto directory = std::filesystem::path(path).parent_path();
+        for (const auto &[shader, type] : data.descriptor.shader_to_type) {
+            data.paths.push_back((directory / shader).string());
+            data.sources.emplace_back(type, read_file(data.paths.back()));
+        }
+
+        return data;
+    }
+
+    // Reloaded along with the descriptor when hot reloading is enabled
+    static std::vector<std::string> dependencies(const Intermediate &data) {
+        return data.paths;
+    }
+
+    static OpenGL::Program finalize(Intermediate &&data) {
+        OpenGL::Program program;
+
+        for (const auto &[type, source] : data.sources) {
+            switch (type) {
+            case ProgramDescriptor::ShaderType::Vertex: program.attach_vertex_shader(source.c_str()); break;
+            case ProgramDescriptor::ShaderType::Fragment: program.attach_fragment_shader(source.c_str()); break;
+            default:
+                throw std::runtime_error("Unsupported shader type in program '" + data.descriptor.name + "'");
+            }
+        }
+
+        program.link();
+        return program;
+    }
+};
+
+}
+
+#endif // _CALICO_GL_PROGRAM_LOADER_HPP_
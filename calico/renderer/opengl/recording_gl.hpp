@@ -0,0 +1,371 @@
+#ifndef __CALICO_GL_RECORDING_GL_HPP__
+#define __CALICO_GL_RECORDING_GL_HPP__
+
+// Stand-in for the OpenGL library that records calls instead of making them, for
+// checking what the renderer sends to GL without a context, e.g. in benchmarks and on
+// machines without a GPU. Include it in exactly one translation unit, before
+// CalicoOpenGLRenderer.hpp, and don't link against libGL.
+//
+// Object names are handed out from a counter, compiles and links always succeed, and
+// queries return zero unless noted otherwise. The recorder follows which program,
+// vertex array and buffers are bound, so a test can check what a draw would have used.
+// Only the functions the renderer uses are defined.
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Calico::OpenGL {
+
+class GLRecorder {
+public:
+    struct Call {
+        std::string_view function;
+        // integer arguments in order, pointers and floats are left out
+        std::array<std::int64_t, 4> args = {};
+    };
+private:
+    std::vector<Call> calls = {};
+    std::unordered_map<std::string_view, std::size_t> counts = {};
+    GLuint next_name = 1;
+    std::unordered_map<GLuint, GLenum> shader_types = {};
+    std::unordered_map<std::string, GLint> uniform_locations = {};
+    std::unordered_map<GLenum, std::vector<std::byte>> mapped = {};
+
+    GLuint program = 0;
+    GLuint vertex_array = 0;
+    std::unordered_map<GLenum, GLuint> buffers = {};
+    // the element array buffer binding belongs to the vertex array
+    std::unordered_map<GLuint, GLuint> element_buffers = {};
+
+    GLRecorder() = default;
+public:
+    // Record the whole call stream, rather than only counting calls
+    bool record_calls = true;
+    // GL version reported to queries, times ten
+    int gl_version = 46;
+
+    static GLRecorder &get() {
+        static GLRecorder recorder;
+        return recorder;
+    }
+
+    void record(std::string_view function, std::initializer_list<std::int64_t> args = {}) {
+        counts[function]++;
+        if (record_calls) {
+            Call call = { .function = function };
+            std::size_t i = 0;
+            for (auto arg : args) {
+                if (i < call.args.size()) {
+                    call.args[i++] = arg;
+                }
+            }
+
+            calls.push_back(call);
+        }
+    }
+
+    // Forget the calls and counts so far, names keep counting
+    void clear() {
+        calls.clear();
+        counts.clear();
+    }
+
+    const std::vector<Call> &get_calls() const noexcept {
+        return calls;
+    }
+
+    std::size_t count(std::string_view function) const {
+        auto found = counts.find(function);
+        return found == counts.end() ? 0 : found->second;
+    }
+
+    std::size_t total() const {
+        std::size_t total = 0;
+        for (const auto &[function, count] : counts) {
+            total += count;
+        }
+
+        return total;
+    }
+
+    // Print the recorded calls, one per line
+    void print(std::FILE *out = stdout) const {
+        for (const auto &call : calls) {
+            std::fprintf(out, "%.*s(%lld, %lld, %lld, %lld)\n", static_cast<int>(call.function.size()),
+                call.function.data(), static_cast<long long>(call.args[0]), static_cast<long long>(call.args[1]),
+                static_cast<long long>(call.args[2]), static_cast<long long>(call.args[3]));
+        }
+    }
+
+    GLuint bound_program() const noexcept {
+        return program;
+    }
+
+    GLuint bound_vertex_array() const noexcept {
+        return vertex_array;
+    }
+
+    GLuint bound_buffer(GLenum target) const {
+        const auto &bindings = target == GL_ELEMENT_ARRAY_BUFFER ? element_buffers : buffers;
+        auto found = bindings.find(target == GL_ELEMENT_ARRAY_BUFFER ? vertex_array : target);
+        return found == bindings.end() ? 0 : found->second;
+    }
+
+    void set_program(GLuint id) noexcept {
+        program = id;
+    }
+
+    void set_vertex_array(GLuint id) noexcept {
+        vertex_array = id;
+    }
+
+    void set_buffer(GLenum target, GLuint id) {
+        if (target == GL_ELEMENT_ARRAY_BUFFER) {
+            element_buffers[vertex_array] = id;
+        } else {
+            buffers[target] = id;
+        }
+    }
+
+    // Like GL, unbind deleted objects
+    void delete_vertex_array(GLuint id) noexcept {
+        if (vertex_array == id) {
+            vertex_array = 0;
+        }
+    }
+
+    void delete_buffer(GLuint id) {
+        for (auto &[target, buffer] : buffers) {
+            if (buffer == id) {
+                buffer = 0;
+            }
+        }
+
+        // only unbound from the vertex array that is bound
+        if (element_buffers[vertex_array] == id) {
+            element_buffers[vertex_array] = 0;
+        }
+    }
+
+    GLuint generate_name() noexcept {
+        return next_name++;
+    }
+
+    void set_shader_type(GLuint shader, GLenum type) {
+        shader_types[shader] = type;
+    }
+
+    GLenum get_shader_type(GLuint shader) const {
+        auto found = shader_types.find(shader);
+        return found == shader_types.end() ? 0 : found->second;
+    }
+
+    GLint uniform_location(const char *name) {
+        auto [location, inserted] = uniform_locations.try_emplace(name, static_cast<GLint>(uniform_locations.size()));
+        return location->second;
+    }
+
+    // Memory standing in for a mapping of the buffer bound to `target`
+    void *map(GLenum target, std::size_t bytes) {
+        auto &memory = mapped[target];
+        memory.resize(bytes);
+        return memory.data();
+    }
+};
+
+}
+
+#define CALICO_GL_RECORD(...) ::Calico::OpenGL::GLRecorder::get().record(__func__, { __VA_ARGS__ })
+
+static void calico_gl_generate(GLsizei n, GLuint *names) {
+    for (GLsizei i = 0; i < n; i++) {
+        names[i] = ::Calico::OpenGL::GLRecorder::get().generate_name();
+    }
+}
+
+// Errors and queries
+
+GLenum APIENTRY glGetError() { return GL_NO_ERROR; }
+GLboolean APIENTRY glIsProgram(GLuint) { return GL_TRUE; }
+GLboolean APIENTRY glIsShader(GLuint) { return GL_TRUE; }
+// the context is GL 4.6, and the uniform buffer offset alignment is 256 as on most
+// desktop GPUs; `GLRecorder::gl_version` overrides the version
+void APIENTRY glGetIntegerv(GLenum pname, GLint *data) {
+    CALICO_GL_RECORD(pname);
+    const auto &recorder = ::Calico::OpenGL::GLRecorder::get();
+    switch (pname) {
+    case GL_MAJOR_VERSION: *data = recorder.gl_version / 10; break;
+    case GL_MINOR_VERSION: *data = recorder.gl_version % 10; break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: *data = 256; break;
+    default: *data = 0;
+    }
+}
+
+void APIENTRY glEnable(GLenum cap) { CALICO_GL_RECORD(cap); }
+void APIENTRY glDisable(GLenum cap) { CALICO_GL_RECORD(cap); }
+void APIENTRY glDepthMask(GLboolean flag) { CALICO_GL_RECORD(flag); }
+void APIENTRY glDepthFunc(GLenum func) { CALICO_GL_RECORD(func); }
+void APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) { CALICO_GL_RECORD(sfactor, dfactor); }
+void APIENTRY glCullFace(GLenum mode) { CALICO_GL_RECORD(mode); }
+
+// Shaders and programs
+
+GLuint APIENTRY glCreateShader(GLenum type) {
+    GLuint shader = ::Calico::OpenGL::GLRecorder::get().generate_name();
+    ::Calico::OpenGL::GLRecorder::get().set_shader_type(shader, type);
+    CALICO_GL_RECORD(type);
+    return shader;
+}
+
+void APIENTRY glShaderSource(GLuint shader, GLsizei count, const GLchar *const*, const GLint*) { CALICO_GL_RECORD(shader, count); }
+void APIENTRY glCompileShader(GLuint shader) { CALICO_GL_RECORD(shader); }
+void APIENTRY glDeleteShader(GLuint shader) { CALICO_GL_RECORD(shader); }
+
+void APIENTRY glGetShaderiv(GLuint shader, GLenum pname, GLint *params) {
+    switch (pname) {
+    case GL_COMPILE_STATUS: *params = GL_TRUE; break;
+    case GL_SHADER_TYPE: *params = ::Calico::OpenGL::GLRecorder::get().get_shader_type(shader); break;
+    default: *params = 0; break;
+    }
+}
+
+void APIENTRY glGetShaderInfoLog(GLuint, GLsizei, GLsizei *length, GLchar *info_log) {
+    if (length) {
+        *length = 0;
+    }
+
+    info_log[0] = '\0';
+}
+
+GLuint APIENTRY glCreateProgram() {
+    CALICO_GL_RECORD();
+    return ::Calico::OpenGL::GLRecorder::get().generate_name();
+}
+
+void APIENTRY glAttachShader(GLuint program, GLuint shader) { CALICO_GL_RECORD(program, shader); }
+void APIENTRY glLinkProgram(GLuint program) { CALICO_GL_RECORD(program); }
+void APIENTRY glDeleteProgram(GLuint program) { CALICO_GL_RECORD(program); }
+void APIENTRY glUseProgram(GLuint program) {
+    CALICO_GL_RECORD(program);
+    ::Calico::OpenGL::GLRecorder::get().set_program(program);
+}
+
+void APIENTRY glGetProgramiv(GLuint, GLenum pname, GLint *params) {
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY glGetProgramInfoLog(GLuint, GLsizei, GLsizei *length, GLchar *info_log) {
+    if (length) {
+        *length = 0;
+    }
+
+    info_log[0] = '\0';
+}
+
+GLint APIENTRY glGetUniformLocation(GLuint program, const GLchar *name) {
+    CALICO_GL_RECORD(program);
+    return ::Calico::OpenGL::GLRecorder::get().uniform_location(name);
+}
+
+GLuint APIENTRY glGetUniformBlockIndex(GLuint program, const GLchar*) { CALICO_GL_RECORD(program); return 0; }
+void APIENTRY glUniformBlockBinding(GLuint program, GLuint index, GLuint binding) { CALICO_GL_RECORD(program, index, binding); }
+void APIENTRY glUniform1f(GLint location, GLfloat) { CALICO_GL_RECORD(location); }
+void APIENTRY glUniform1i(GLint location, GLint v0) { CALICO_GL_RECORD(location, v0); }
+void APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat*) { CALICO_GL_RECORD(location, count); }
+void APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat*) { CALICO_GL_RECORD(location, count); }
+void APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat*) { CALICO_GL_RECORD(location, count, transpose); }
+
+// Buffers and vertex arrays
+
+void APIENTRY glGenBuffers(GLsizei n, GLuint *buffers) { CALICO_GL_RECORD(n); calico_gl_generate(n, buffers); }
+void APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+    CALICO_GL_RECORD(n);
+    for (GLsizei i = 0; i < n; i++) {
+        ::Calico::OpenGL::GLRecorder::get().delete_buffer(buffers[i]);
+    }
+}
+void APIENTRY glBindBuffer(GLenum target, GLuint buffer) {
+    CALICO_GL_RECORD(target, buffer);
+    ::Calico::OpenGL::GLRecorder::get().set_buffer(target, buffer);
+}
+void APIENTRY glBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    CALICO_GL_RECORD(target, index, buffer);
+    ::Calico::OpenGL::GLRecorder::get().set_buffer(target, buffer);
+}
+
+void APIENTRY glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    CALICO_GL_RECORD(target, index, buffer, offset);
+    ::Calico::OpenGL::GLRecorder::get().set_buffer(target, buffer);
+    (void) size;
+}
+
+void APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void*, GLenum usage) { CALICO_GL_RECORD(target, size, usage); }
+void APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void*) { CALICO_GL_RECORD(target, offset, size); }
+void APIENTRY glBufferStorage(GLenum target, GLsizeiptr size, const void*, GLbitfield flags) { CALICO_GL_RECORD(target, size, flags); }
+
+void *APIENTRY glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    CALICO_GL_RECORD(target, offset, length, access);
+    return ::Calico::OpenGL::GLRecorder::get().map(target, offset + length);
+}
+
+GLboolean APIENTRY glUnmapBuffer(GLenum target) { CALICO_GL_RECORD(target); return GL_TRUE; }
+
+void APIENTRY glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+    CALICO_GL_RECORD(target, offset, length);
+}
+
+void APIENTRY glGenVertexArrays(GLsizei n, GLuint *arrays) { CALICO_GL_RECORD(n); calico_gl_generate(n, arrays); }
+void APIENTRY glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {
+    CALICO_GL_RECORD(n);
+    for (GLsizei i = 0; i < n; i++) {
+        ::Calico::OpenGL::GLRecorder::get().delete_vertex_array(arrays[i]);
+    }
+}
+void APIENTRY glBindVertexArray(GLuint array) {
+    CALICO_GL_RECORD(array);
+    ::Calico::OpenGL::GLRecorder::get().set_vertex_array(array);
+}
+void APIENTRY glEnableVertexAttribArray(GLuint index) { CALICO_GL_RECORD(index); }
+void APIENTRY glVertexAttribDivisor(GLuint index, GLuint divisor) { CALICO_GL_RECORD(index, divisor); }
+
+void APIENTRY glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void*) {
+    CALICO_GL_RECORD(index, size, type, stride);
+    (void) normalized;
+}
+
+// Drawing
+
+void APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void*) { CALICO_GL_RECORD(mode, count, type); }
+
+void APIENTRY glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void*, GLsizei instancecount) {
+    CALICO_GL_RECORD(mode, count, type, instancecount);
+}
+
+// Synchronization, fences are always signaled
+
+GLsync APIENTRY glFenceSync(GLenum condition, GLbitfield flags) {
+    CALICO_GL_RECORD(condition, flags);
+    return reinterpret_cast<GLsync>(static_cast<std::uintptr_t>(::Calico::OpenGL::GLRecorder::get().generate_name()));
+}
+
+GLenum APIENTRY glClientWaitSync(GLsync, GLbitfield flags, GLuint64 timeout) {
+    CALICO_GL_RECORD(flags, static_cast<std::int64_t>(timeout));
+    return GL_ALREADY_SIGNALED;
+}
+
+void APIENTRY glDeleteSync(GLsync) { CALICO_GL_RECORD(); }
+
+#undef CALICO_GL_RECORD
+
+#endif // __CALICO_GL_RECORDING_GL_HPP__
@@ -0,0 +1,146 @@
+#ifndef __CALICO_GL_RENDER_QUEUE_HPP__
+#define __CALICO_GL_RENDER_QUEUE_HPP__
+
+namespace Calico::OpenGL {
+
+// 64-bit key ordering draws by the state they need, most expensive to change first:
+//
+//     63        48 47        32 31        16 15         0
+//     | program   | material   | vertex arr | depth      |
+//
+// Programs and vertex arrays are identified by the low bits of their GL names, which
+// are small integers in practice; two objects sharing a key only sort less well, since
+// binds are elided by comparing the objects themselves. Depth comes last so draws with
+// the same state go front to back.
+struct DrawKey {
+    static constexpr std::uint64_t Program_Shift = 48;
+    static constexpr std::uint64_t Material_Shift = 32;
+    static constexpr std::uint64_t Vertex_Array_Shift = 16;
+
+    // `depth` is the view depth normalized to [0, 1], values outside are clamped
+    static std::uint64_t make(program_t program, std::uint16_t material, vao_t vertex_array, float depth) noexcept {
+        float clamped = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        auto quantized = static_cast<std::uint64_t>(clamped * 65535.0f + 0.5f);
+
+        return (static_cast<std::uint64_t>(program & 0xffff) << Program_Shift)
+            | (static_cast<std::uint64_t>(material) << Material_Shift)
+            | (static_cast<std::uint64_t>(vertex_array & 0xffff) << Vertex_Array_Shift)
+            | quantized;
+    }
+};
+
+struct DrawPacket {
+    std::uint64_t key = 0;
+    Program *program = nullptr;
+    IVertexArray *vertex_array = nullptr;
+    std::uint16_t material = 0;
+};
+
+// What the last `RenderQueue::submit` sent to GL
+struct RenderQueueStats {
+    std::size_t draws = 0;
+    std::size_t program_binds = 0;
+    std::size_t material_binds = 0;
+    std::size_t vertex_array_binds = 0;
+
+    // binds skipped compared to binding everything for every draw
+    std::size_t elided_binds() const noexcept {
+        std::size_t binds = program_binds + vertex_array_binds;
+        return binds < 2 * draws ? 2 * draws - binds : 0;
+    }
+};
+
+// Collects the frame's draws and submits them sorted by `DrawKey`, binding a program,
+// material or vertex array only when it differs from the previous draw's.
+//
+// Packets are pushed in any order, then radix sorted by key; draws with equal keys keep
+// the order they were pushed in. The queue keeps its buffers between frames, so it
+// stops allocating once it has seen the largest frame.
+class RenderQueue {
+public:
+    // Called when the draws switch to another material, with its program bound
+    using MaterialBinder = Delegate<void(Program &program, std::uint16_t material)>;
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::uint32_t packet;
+    };
+
+    std::vector<DrawPacket> packets = {};
+    std::vector<Entry> order = {};
+    std::vector<Entry> scratch = {};
+    RenderQueueStats stats = {};
+public:
+    void push(Program &program, IVertexArray &vertex_array, std::uint16_t material = 0, float depth = 0.0f) {
+        packets.push_back({
+            .key = DrawKey::make(program, material, vertex_array.get_id(), depth),
+            .program = &program,
+            .vertex_array = &vertex_array,
+            .material = material,
+        });
+    }
+
+    // Draw everything pushed since the last submit, then empty the queue. Binds go
+    // through the `StateCache`, so state left bound from before is reused too.
+    void submit(const MaterialBinder &bind_material = {}) {
+        order.resize(packets.size());
+        scratch.resize(packets.size());
+        for (std::size_t i = 0; i < packets.size(); i++) {
+            order[i] = { packets[i].key, static_cast<std::uint32_t>(i) };
+        }
+
+        radix_sort(std::span(order), std::span(scratch), [](const Entry &entry) { return entry.key; });
+
+        stats = {};
+        auto &cache = StateCache::get();
+        const Program *program = nullptr;
+        const IVertexArray *vertex_array = nullptr;
+        std::optional<std::uint16_t> material = std::nullopt;
+
+        for (const auto &entry : order) {
+            const DrawPacket &packet = packets[entry.packet];
+
+            if (packet.program != program) {
+                program = packet.program;
+                cache.use_program(*program);
+                stats.program_binds++;
+                // materials are uniforms of the program
+                material.reset();
+            }
+
+            if (packet.material != material) {
+                material = packet.material;
+                stats.material_binds++;
+
+                if (bind_material) {
+                    bind_material(*packet.program, packet.material);
+                    // in case the binder used another program, free otherwise
+                    cache.use_program(*program);
+                }
+            }
+
+            if (packet.vertex_array != vertex_array) {
+                vertex_array = packet.vertex_array;
+                cache.bind_vertex_array(vertex_array->get_id());
+                stats.vertex_array_binds++;
+            }
+
+            GLCALL(glDrawElements(GL_TRIANGLES, vertex_array->get_index_count(), GL_UNSIGNED_INT, 0));
+            stats.draws++;
+        }
+
+        packets.clear();
+    }
+
+    std::size_t size() const noexcept {
+        return packets.size();
+    }
+
+    const RenderQueueStats &get_stats() const noexcept {
+        return stats;
+    }
+};
+
+}
+
+#endif // __CALICO_GL_RENDER_QUEUE_HPP__
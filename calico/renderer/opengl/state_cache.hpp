@@ -0,0 +1,185 @@
+#ifndef __CALICO_GL_STATE_CACHE_HPP__
+#define __CALICO_GL_STATE_CACHE_HPP__
+
+namespace Calico::OpenGL {
+
+// Calls made and skipped for one kind of binding
+struct BindCounter {
+    std::size_t issued = 0;
+    std::size_t avoided = 0;
+};
+
+struct StateCacheStats {
+    BindCounter programs = {};
+    BindCounter vertex_arrays = {};
+    BindCounter buffers = {};
+    BindCounter buffer_ranges = {};
+
+    std::size_t issued() const noexcept {
+        return programs.issued + vertex_arrays.issued + buffers.issued + buffer_ranges.issued;
+    }
+
+    std::size_t avoided() const noexcept {
+        return programs.avoided + vertex_arrays.avoided + buffers.avoided + buffer_ranges.avoided;
+    }
+};
+
+// Shadow copy of the GL bindings of the context, so binding an object that is already
+// bound costs nothing. Every wrapper in `Calico::OpenGL` binds through it and leaves
+// its objects bound rather than unbinding them afterwards; code calling GL directly
+// must either do the same or call `invalidate` after changing bindings itself.
+//
+// State that isn't known, at startup or after an object was deleted, is always
+// rebound. The element array buffer binding is part of the vertex array, so it is
+// forgotten whenever the vertex array changes.
+class StateCache {
+    static constexpr std::uint32_t Unknown = ~0u;
+
+    struct BufferRange {
+        std::uint32_t buffer = Unknown;
+        std::ptrdiff_t offset = 0;
+        std::ptrdiff_t size = 0;
+    };
+
+    static constexpr std::size_t Max_Range_Bindings = 16;
+
+    std::uint32_t program = Unknown;
+    std::uint32_t vertex_array = Unknown;
+    std::uint32_t array_buffer = Unknown;
+    std::uint32_t element_array_buffer = Unknown;
+    std::uint32_t uniform_buffer = Unknown;
+    std::uint32_t other_buffers[2] = { Unknown, Unknown };
+    // stands in for the binding of targets that aren't tracked, always unknown
+    std::uint32_t untracked = Unknown;
+    // indexed uniform buffer bindings, larger indices are never cached
+    std::array<BufferRange, Max_Range_Bindings> uniform_ranges = {};
+
+    StateCacheStats stats = {};
+
+    StateCache() = default;
+
+    std::uint32_t &buffer_binding(GLenum target) noexcept {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return element_array_buffer;
+        case GL_UNIFORM_BUFFER: return uniform_buffer;
+        case GL_COPY_READ_BUFFER: return other_buffers[0];
+        case GL_COPY_WRITE_BUFFER: return other_buffers[1];
+        default:
+            untracked = Unknown;
+            return untracked;
+        }
+    }
+
+    static bool update(std::uint32_t &current, std::uint32_t value, BindCounter &counter) noexcept {
+        if (current == value) {
+            counter.avoided++;
+            return false;
+        }
+
+        current = value;
+        counter.issued++;
+        return true;
+    }
+public:
+    StateCache(const StateCache &rhs) = delete;
+    void operator=(const StateCache &rhs) = delete;
+
+    // The cache of the current context; the renderer uses a single context
+    static StateCache &get() {
+        static StateCache cache;
+        return cache;
+    }
+
+    void use_program(program_t id) {
+        if (update(program, id, stats.programs)) {
+            GLCALL(glUseProgram(id));
+        }
+    }
+
+    void bind_vertex_array(vao_t id) {
+        if (update(vertex_array, id, stats.vertex_arrays)) {
+            GLCALL(glBindVertexArray(id));
+            element_array_buffer = Unknown;
+        }
+    }
+
+    void bind_buffer(GLenum target, std::uint32_t id) {
+        if (update(buffer_binding(target), id, stats.buffers)) {
+            GLCALL(glBindBuffer(target, id));
+        }
+    }
+
+    // `glBindBufferRange`, which also binds the buffer to the generic `target`
+    void bind_buffer_range(GLenum target, std::uint32_t index, std::uint32_t id, std::ptrdiff_t offset, std::ptrdiff_t size) {
+        if (target == GL_UNIFORM_BUFFER && index < Max_Range_Bindings) {
+            auto &range = uniform_ranges[index];
+            if (range.buffer == id && range.offset == offset && range.size == size) {
+                stats.buffer_ranges.avoided++;
+                return;
+            }
+
+            range = { id, offset, size };
+        }
+
+        stats.buffer_ranges.issued++;
+        GLCALL(glBindBufferRange(target, index, id, offset, size));
+        buffer_binding(target) = id;
+    }
+
+    // Call when deleting a program, the name may be reused
+    void forget_program(program_t id) noexcept {
+        if (program == id) {
+            program = Unknown;
+        }
+    }
+
+    // Call when deleting a vertex array; GL unbinds it if it is bound
+    void forget_vertex_array(vao_t id) noexcept {
+        if (vertex_array == id) {
+            vertex_array = Unknown;
+            element_array_buffer = Unknown;
+        }
+    }
+
+    // Call when deleting a buffer; GL unbinds it everywhere it is bound
+    void forget_buffer(std::uint32_t id) noexcept {
+        for (auto *binding : { &array_buffer, &element_array_buffer, &uniform_buffer, &other_buffers[0], &other_buffers[1] }) {
+            if (*binding == id) {
+                *binding = Unknown;
+            }
+        }
+
+        for (auto &range : uniform_ranges) {
+            if (range.buffer == id) {
+                range.buffer = Unknown;
+            }
+        }
+    }
+
+    // Forget everything, after GL state was changed behind the cache's back or the
+    // context was recreated
+    void invalidate() noexcept {
+        program = Unknown;
+        vertex_array = Unknown;
+        array_buffer = Unknown;
+        element_array_buffer = Unknown;
+        uniform_buffer = Unknown;
+        other_buffers[0] = Unknown;
+        other_buffers[1] = Unknown;
+        uniform_ranges.fill({});
+    }
+
+    const StateCacheStats &get_stats() const noexcept {
+        return stats;
+    }
+
+    // Counters of the frame that just ended, starting the next one from zero
+    StateCacheStats end_frame() noexcept {
+        return std::exchange(stats, {});
+    }
+};
+
+}
+
+#endif // __CALICO_GL_STATE_CACHE_HPP__
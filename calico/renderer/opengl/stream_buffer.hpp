@@ -0,0 +1,208 @@
+#ifndef __CALICO_GL_STREAM_BUFFER_HPP__
+#define __CALICO_GL_STREAM_BUFFER_HPP__
+
+namespace Calico::OpenGL {
+
+// Persistent mapping needs GL 4.4 or ARB_buffer_storage, which headers stopping at an
+// older version, like macOS's gl3.h at 4.1, don't declare
+#ifdef GL_MAP_PERSISTENT_BIT
+#define CALICO_GL_BUFFER_STORAGE
+#endif // GL_MAP_PERSISTENT_BIT
+
+// Part of a `StreamBuffer` written this frame. `offset` is from the start of the
+// buffer, for binding it or pointing attributes at it.
+struct StreamAllocation {
+    std::size_t offset = 0;
+    std::size_t size = 0;
+};
+
+// Ring of `frames` regions in one buffer, for data rewritten every frame: uniform
+// blocks, instance data and dynamic geometry. Writes are bound by offset with
+// `glBindBufferRange` or as attribute pointers.
+//
+// Each frame writes into its own region; `end_frame` fences it and moves on to the
+// next, waiting only if the GPU is still reading that region from `frames` frames ago.
+// With GL 4.4 the buffer stays mapped, coherently, for its whole life and writes go
+// straight into the mapping. Otherwise each write maps just its range without
+// synchronizing, which the fences make safe, and unmaps it again.
+class StreamBuffer {
+#ifdef CALICO_GL_BUFFER_STORAGE
+    static constexpr GLbitfield Persistent_Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+#endif // CALICO_GL_BUFFER_STORAGE
+    static constexpr GLbitfield Write_Flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+
+    std::uint32_t buffer_id = 0;
+    // the persistent mapping of the whole buffer, null when writes map their range
+    std::byte *mapped = nullptr;
+    std::size_t uniform_alignment = 0;
+    std::size_t region_size = 0;
+    std::size_t frame = 0;
+    // bytes written to the current region
+    std::size_t head = 0;
+    std::vector<GLsync> fences = {};
+    std::size_t stalls = 0;
+
+    static std::size_t align_up(std::size_t value, std::size_t alignment) noexcept {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static bool supports_buffer_storage() {
+#ifdef CALICO_GL_BUFFER_STORAGE
+        GLint major = 0;
+        GLint minor = 0;
+        GLCALL(glGetIntegerv(GL_MAJOR_VERSION, &major));
+        GLCALL(glGetIntegerv(GL_MINOR_VERSION, &minor));
+        return major > 4 || (major == 4 && minor >= 4);
+#else
+        return false;
+#endif // CALICO_GL_BUFFER_STORAGE
+    }
+
+    // Reserve `bytes` of this frame's region, at an offset that is a multiple of
+    // `alignment`. Throws when the region is full.
+    StreamAllocation allocate(std::size_t bytes, std::size_t alignment) {
+        std::size_t start = align_up(head, alignment);
+        if (start + bytes > region_size) {
+            throw std::runtime_error("Stream buffer region is full");
+        }
+
+        head = start + bytes;
+        return { frame * region_size + start, bytes };
+    }
+
+    void wait_for(GLsync fence) {
+        // poll first so only real waits are counted
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            stalls++;
+            do {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+
+        if (status == GL_WAIT_FAILED) {
+            throw std::runtime_error("Failed to wait for stream buffer fence");
+        }
+    }
+public:
+    // `bytes_per_frame` is rounded up to the uniform buffer offset alignment
+    StreamBuffer(std::size_t bytes_per_frame, std::size_t frames = 3) : fences(frames, nullptr) {
+        if (bytes_per_frame == 0 || frames == 0) {
+            throw std::runtime_error("Stream buffer must not be empty");
+        }
+
+        GLint alignment = 0;
+        GLCALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+        uniform_alignment = alignment > 0 ? static_cast<std::size_t>(alignment) : 256;
+        region_size = align_up(bytes_per_frame, uniform_alignment);
+
+        GLCALL(glGenBuffers(1, &buffer_id));
+        StateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, buffer_id);
+
+#ifdef CALICO_GL_BUFFER_STORAGE
+        if (supports_buffer_storage()) {
+            GLCALL(glBufferStorage(GL_COPY_WRITE_BUFFER, region_size * frames, nullptr, Persistent_Flags));
+            mapped = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, region_size * frames, Persistent_Flags));
+
+            if (mapped == nullptr) {
+                StateCache::get().forget_buffer(buffer_id);
+                glDeleteBuffers(1, &buffer_id);
+                throw std::runtime_error("Failed to map stream buffer");
+            }
+
+            return;
+        }
+#endif // CALICO_GL_BUFFER_STORAGE
+
+        GLCALL(glBufferData(GL_COPY_WRITE_BUFFER, region_size * frames, nullptr, GL_STREAM_DRAW));
+    }
+
+    StreamBuffer(const StreamBuffer &rhs) = delete;
+    void operator=(const StreamBuffer &rhs) = delete;
+
+    // Deleting the buffer also unmaps it
+    ~StreamBuffer() {
+        for (GLsync fence : fences) {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+            }
+        }
+
+        StateCache::get().forget_buffer(buffer_id);
+        glDeleteBuffers(1, &buffer_id);
+    }
+
+    // Copy `bytes` into this frame's region, at an offset that is a multiple of
+    // `alignment`. Throws when the region is full.
+    StreamAllocation write(const void *data, std::size_t bytes, std::size_t alignment = 16) {
+        auto allocation = allocate(bytes, alignment);
+        if (mapped != nullptr) {
+            std::memcpy(mapped + allocation.offset, data, bytes);
+            return allocation;
+        } else if (bytes == 0) {
+            return allocation;
+        }
+
+        StateCache::get().bind_buffer(GL_COPY_WRITE_BUFFER, buffer_id);
+        void *range = glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.offset, bytes, Write_Flags);
+        if (range == nullptr) {
+            throw std::runtime_error("Failed to map stream buffer range");
+        }
+
+        std::memcpy(range, data, bytes);
+        GLCALL(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+        return allocation;
+    }
+
+    void bind_range(GLenum target, std::uint32_t index, const StreamAllocation &allocation) {
+        StateCache::get().bind_buffer_range(target, index, buffer_id, allocation.offset, allocation.size);
+    }
+
+    // Write a uniform block and bind it to the uniform buffer binding `index`
+    StreamAllocation bind_uniform_block(std::uint32_t index, const void *data, std::size_t bytes) {
+        auto allocation = write(data, bytes, uniform_alignment);
+        bind_range(GL_UNIFORM_BUFFER, index, allocation);
+        return allocation;
+    }
+
+    // Call once the frame's draws have been issued. Fences the region they read and
+    // moves on to the next one, waiting until the GPU is done with it.
+    void end_frame() {
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame = (frame + 1) % fences.size();
+        head = 0;
+
+        if (fences[frame] != nullptr) {
+            wait_for(fences[frame]);
+            glDeleteSync(fences[frame]);
+            fences[frame] = nullptr;
+        }
+    }
+
+    inline std::uint32_t get_id() const noexcept {
+        return buffer_id;
+    }
+
+    // Whether the buffer is persistently mapped rather than mapped per write
+    inline bool is_persistent() const noexcept {
+        return mapped != nullptr;
+    }
+
+    inline std::size_t get_region_size() const noexcept {
+        return region_size;
+    }
+
+    // Bytes written to the current region so far
+    inline std::size_t get_used() const noexcept {
+        return head;
+    }
+
+    // Times `end_frame` had to wait for the GPU
+    inline std::size_t get_stalls() const noexcept {
+        return stalls;
+    }
+};
+
+}
+
+#endif // __CALICO_GL_STREAM_BUFFER_HPP__
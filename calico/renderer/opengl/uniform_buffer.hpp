@@ -3,79 +3,81 @@
 
 namespace Calico::OpenGL {
 
+// Uniform block laid out with std140 rules, with a CPU copy of its contents.
+//
+// `set_data` only writes the copy and widens the range of bytes changed since the last
+// upload; `flush`, once a frame before drawing, uploads that range in one call. Members
+// are identified by their index in `set_contents`; `UniformBlock` checks the index and
+// type at compile time.
 class UniformBuffer {
 private:
     // delete and mark copy constructors as private
     UniformBuffer(const UniformBuffer &rhs) = delete;
     void operator=(const UniformBuffer &rhs) = delete;
 
-    struct UniformBufferMemberTag {
-        std::size_t size;
+    struct MemberLocation {
         std::size_t offset;
+        std::size_t size;
+        std::type_index type;
     };
 
-    std::unordered_map<std::string, UniformBufferMemberTag> member_locations;
-
     static uint32_t ubo_count;
     std::string name = {};
     uint32_t ubo_id = 0;
     uint32_t binding_index = 0;
-    uint32_t offset = 0;
-
-    static std::size_t get_glsl_size(std::type_index type) {
-        static const std::unordered_map<std::type_index, std::size_t> type_sizes = {
-            { std::type_index(typeid(float)), 4 },
-            { std::type_index(typeid(int32_t)), 4 },
-            { std::type_index(typeid(bool)), 4 },
-            { std::type_index(typeid(glm::vec3)), 12 },
-            { std::type_index(typeid(glm::mat4)), 64 },
-        };
-
-        if (type_sizes.contains(type)) {
-            return type_sizes.at(std::type_index(type));
-        } else {
-            throw std::runtime_error("Unrecognized type");
-        }
+
+    std::vector<MemberLocation> members = {};
+    std::vector<std::string> member_names = {};
+    std::vector<std::byte> shadow = {};
+    // bytes of `shadow` changed since the last flush, empty when `dirty_begin == dirty_end`
+    std::size_t dirty_begin = 0;
+    std::size_t dirty_end = 0;
+    // whether the binding points at a `StreamBuffer` rather than the buffer
+    bool streamed = false;
+
+    void create_buffer(std::size_t bytes) {
+        auto &cache = StateCache::get();
+        cache.bind_buffer(GL_UNIFORM_BUFFER, ubo_id);
+        GLCALL(glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW));
+        cache.bind_buffer_range(GL_UNIFORM_BUFFER, binding_index, ubo_id, 0, bytes);
     }
-    // one name for each type
-    // requires sizeof...(Types) == sizeof...(Names) and Names = const char* or std::string
-    template <typename Type, typename... Types, typename Name, typename... Names>
-        requires (sizeof...(Types) == sizeof...(Names))
-    void calculate_offsets(Name name, Names... names) {
-        auto type_size = get_glsl_size(std::type_index(typeid(Type)));
-        member_locations.insert({ name, { type_size, offset } });
-        offset += type_size;
-
-        if constexpr (sizeof...(Types) > 0) {
-            // set_contents<Types...>(std::forward<Names...>(names...));
-            calculate_offsets<Types...>(names...);
+
+    void mark_dirty(std::size_t begin, std::size_t end) noexcept {
+        if (dirty_begin == dirty_end) {
+            dirty_begin = begin;
+            dirty_end = end;
+        } else {
+            dirty_begin = std::min(dirty_begin, begin);
+            dirty_end = std::max(dirty_end, end);
         }
     }
-
-    void create_buffer(std::size_t bytes) {
-        GLCALL(glBindBuffer(GL_UNIFORM_BUFFER, ubo_id));
-        GLCALL(glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_STATIC_DRAW));
-        GLCALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-        GLCALL(glBindBufferRange(GL_UNIFORM_BUFFER, binding_index, ubo_id, 0, bytes));
+protected:
+    template <typename T>
+    void write_member(std::size_t member, const T &data) {
+        const auto &location = members[member];
+        BlockMember<BlockLayout::Std140, T>::write(shadow.data() + location.offset, data);
+        mark_dirty(location.offset, location.offset + location.size);
     }
 public:
-    // UniformBuffer() : name("") {}
     UniformBuffer(const std::string &name) : name(name) {
         binding_index = UniformBuffer::ubo_count++;
         GLCALL(glGenBuffers(1, &ubo_id));
     }
 
-    UniformBuffer(UniformBuffer &&rhs) : name(rhs.name) {
-        std::swap(this->ubo_id, rhs.ubo_id);
-        std::swap(this->binding_index, rhs.binding_index);
-        std::swap(this->offset, rhs.offset);
+    UniformBuffer(UniformBuffer &&rhs) {
+        *this = std::move(rhs);
     }
 
     void operator=(UniformBuffer &&rhs) {
         this->name = std::move(rhs.name);
         std::swap(this->ubo_id, rhs.ubo_id);
         std::swap(this->binding_index, rhs.binding_index);
-        std::swap(this->offset, rhs.offset);
+        std::swap(this->members, rhs.members);
+        std::swap(this->member_names, rhs.member_names);
+        std::swap(this->shadow, rhs.shadow);
+        std::swap(this->dirty_begin, rhs.dirty_begin);
+        std::swap(this->dirty_end, rhs.dirty_end);
+        std::swap(this->streamed, rhs.streamed);
     }
 
     inline const std::string &get_name() const {
@@ -86,26 +88,108 @@ public:
         return binding_index;
     }
 
+    // size of the block, including std140 padding
+    inline std::size_t get_size() const {
+        return shadow.size();
+    }
+
+    // The block's members, in the order the shader declares them. Names are optional,
+    // one per type, and only used by `get_member_index`.
     template <typename... Types, typename... Names>
-        requires (sizeof...(Types) == sizeof...(Names))
+        requires (sizeof...(Names) == 0 || sizeof...(Types) == sizeof...(Names))
     void set_contents(Names... names) {
-        calculate_offsets<Types...>(names...);
-        create_buffer(offset);
+        using Layout = Std140<Types...>;
+
+        [this]<std::size_t... I>(std::index_sequence<I...>) {
+            members = { MemberLocation{ Layout::offsets[I], Layout::sizes[I], std::type_index(typeid(Types)) }... };
+        }(std::index_sequence_for<Types...>{});
+        member_names = { std::string(names)... };
+
+        shadow.assign(Layout::size, std::byte{ 0 });
+        create_buffer(Layout::size);
+        // the buffer starts undefined, the first flush uploads everything
+        dirty_begin = 0;
+        dirty_end = Layout::size;
+    }
+
+    // Index of the member called `name` in `set_contents`, to look up once rather
+    // than per `set_data`
+    std::size_t get_member_index(std::string_view name) const {
+        for (std::size_t i = 0; i < member_names.size(); i++) {
+            if (member_names[i] == name) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("Uniform buffer has no member " + std::string(name));
     }
 
-    template<typename T>
-    void set_data(const std::string &name, const T &data) {
-        // check if name in `member_locations` and that name does refer to a member of type `T`
-        auto [size, var_offset] = member_locations[name];
+    // Write member `member` of the CPU copy; the GPU sees it after the next `flush`
+    template <typename T>
+    void set_data(std::size_t member, const T &data) {
+        if (member >= members.size()) {
+            throw std::runtime_error("Uniform buffer member index out of range");
+        } else if (members[member].type != std::type_index(typeid(T))) {
+            throw std::runtime_error("Uniform buffer member has another type");
+        }
+
+        write_member(member, data);
+    }
+
+    // Upload the bytes changed since the last flush with one `glBufferSubData`
+    void flush() {
+        auto &cache = StateCache::get();
+        if (streamed) {
+            // the buffer missed every change made while the block was streamed
+            cache.bind_buffer_range(GL_UNIFORM_BUFFER, binding_index, ubo_id, 0, shadow.size());
+            streamed = false;
+            dirty_begin = 0;
+            dirty_end = shadow.size();
+        }
+
+        if (dirty_begin == dirty_end) {
+            return;
+        }
+
+        cache.bind_buffer(GL_UNIFORM_BUFFER, ubo_id);
+        GLCALL(glBufferSubData(GL_UNIFORM_BUFFER, dirty_begin, dirty_end - dirty_begin, shadow.data() + dirty_begin));
+        dirty_begin = dirty_end = 0;
+    }
 
-        GLCALL(glBindBuffer(GL_UNIFORM_BUFFER, ubo_id));
-        GLCALL(glBufferSubData(GL_UNIFORM_BUFFER, var_offset, size, &data));
-        GLCALL(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    // Write the whole block to this frame's region of `stream` and bind it there
+    // instead of to the buffer, for blocks that change every frame
+    void flush(StreamBuffer &stream) {
+        stream.bind_uniform_block(binding_index, shadow.data(), shadow.size());
+        streamed = true;
+        dirty_begin = dirty_end = 0;
     }
 };
 
 uint32_t UniformBuffer::ubo_count = 0;
 
+// `UniformBuffer` whose members `Types` are known at compile time, set by index with
+// `set<I>` without the checks of `set_data`:
+//
+//     UniformBlock<glm::mat4, glm::vec3, float> globals("Globals");
+//     globals.set<0>(view_projection);
+//     globals.flush();
+template <typename... Types>
+class UniformBlock : public UniformBuffer {
+public:
+    using Layout = Std140<Types...>;
+
+    template <typename... Names>
+    UniformBlock(const std::string &name, Names... names) : UniformBuffer(name) {
+        set_contents<Types...>(names...);
+    }
+
+    template <std::size_t I>
+        requires (I < sizeof...(Types))
+    void set(const typename Layout::template Member<I> &data) {
+        write_member(I, data);
+    }
+};
+
 }
 
 #endif // __CALICO_GL_UNIFORM_BUFFER_HPP__
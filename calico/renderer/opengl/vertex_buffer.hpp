@@ -7,18 +7,101 @@ class IVertexArray {
 public:
     virtual ~IVertexArray() = default;
     virtual void draw(const Program &) = 0;
+    virtual void draw_instanced(const Program &, std::size_t instances) = 0;
+    // Replace the per-instance attributes with `count` instances of `bytes` in total
+    virtual void set_instance_data(const void *data, std::size_t bytes, std::size_t count) = 0;
+    // Like `set_instance_data`, but written to this frame's region of `stream`. Vertex
+    // arrays that can't point their attributes into it upload the data themselves.
+    virtual void set_instance_data(StreamBuffer &, const void *data, std::size_t bytes, std::size_t count) {
+        set_instance_data(data, bytes, count);
+    }
+    virtual vao_t get_id() const noexcept = 0;
+    virtual std::size_t get_index_count() const noexcept = 0;
+    virtual std::size_t get_instance_count() const noexcept = 0;
 };
 
+// Mesh with one attribute per type in `Types`, at locations 0 onwards, drawn from an
+// index buffer.
+//
+// It can also have per-instance attributes, set with `set_instance_layout`, which come
+// after the vertex attributes and advance once per instance. Drawing the mesh many times
+// is then one `draw_instanced` with the instances' data, e.g. their model matrices, in
+// one buffer, rather than a draw and uniform upload for each copy.
 template <typename... Types>
 class VertexArray final : public IVertexArray {
+    // One attribute location of the instance layout; matrices take one per column
+    struct InstanceAttribute {
+        std::uint32_t location;
+        std::int32_t components;
+        std::size_t offset;
+    };
+
     vao_t vao_id = 0;
     vbo_t vbo_id = 0;
     ebo_t ebo_id = 0;
+    vbo_t instance_vbo_id = 0;
+    // buffer the instance attributes currently point into, the instance buffer or a stream
+    vbo_t instance_source = 0;
 
     std::size_t vertex_count = 0;
     std::size_t offset = 0;
     std::size_t attrib_index = 0;
 
+    std::vector<InstanceAttribute> instance_attributes = {};
+    std::size_t instance_stride = 0;
+    std::size_t instance_count = 0;
+    // size of the instance buffer's storage, which is only reallocated to grow
+    std::size_t instance_capacity = 0;
+
+    // Attribute locations and floats per location taken by an instance attribute
+    template <typename T>
+    static constexpr std::pair<std::uint32_t, std::int32_t> instance_attribute_shape() {
+        if constexpr (std::is_same_v<T, float>) {
+            return { 1, 1 };
+        } else if constexpr (std::is_same_v<T, glm::vec2>) {
+            return { 1, 2 };
+        } else if constexpr (std::is_same_v<T, glm::vec3>) {
+            return { 1, 3 };
+        } else if constexpr (std::is_same_v<T, glm::vec4>) {
+            return { 1, 4 };
+        } else if constexpr (std::is_same_v<T, glm::mat4>) {
+            return { 4, 4 };
+        } else {
+            static_assert(!sizeof(T), "Unsupported instance attribute type");
+        }
+    }
+
+    template <typename T>
+    void add_instance_attribute(std::uint32_t &location) {
+        auto [locations, components] = instance_attribute_shape<T>();
+        for (std::uint32_t i = 0; i < locations; i++) {
+            instance_attributes.push_back({ location++, components, instance_stride });
+            instance_stride += components * sizeof(float);
+        }
+    }
+
+    // Point the instance attributes at `buffer`, starting `base` bytes in
+    void point_instance_attributes(vbo_t buffer, std::size_t base) {
+        auto &cache = StateCache::get();
+        cache.bind_vertex_array(vao_id);
+        cache.bind_buffer(GL_ARRAY_BUFFER, buffer);
+
+        for (const auto &attribute : instance_attributes) {
+            GLCALL(glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE,
+                instance_stride, (void*) (base + attribute.offset)));
+        }
+
+        instance_source = buffer;
+    }
+
+    void check_instance_data(std::size_t bytes, std::size_t count) const {
+        if (instance_attributes.empty()) {
+            throw std::runtime_error("Vertex array has no instance layout");
+        } else if (bytes != count * instance_stride) {
+            throw std::runtime_error("Instance data doesn't match the instance layout");
+        }
+    }
+
     static std::size_t glsl_get_elements_per_type(std::type_index type) {
         static const std::unordered_map<std::type_index, std::size_t> type_to_elements = {
             { std::type_index(typeid(float)), 1 },
@@ -62,6 +145,21 @@ class VertexArray final : public IVertexArray {
             _set_data<_Types...>(arrays...);
         }
     }
+
+    template <typename Type, typename... _Types, typename Array, typename... Arrays>
+    void _stream_data(StreamBuffer &stream, std::uint32_t index, const Array &array, const Arrays &...arrays) {
+        std::span<const float> data(array);
+        std::size_t elements_per_type = glsl_get_elements_per_type(std::type_index(typeid(Type)));
+        auto allocation = stream.write(data.data(), data.size_bytes(), sizeof(float));
+
+        GLCALL(glVertexAttribPointer(index, elements_per_type, GL_FLOAT, GL_FALSE,
+                elements_per_type * sizeof(float), (void*) allocation.offset));
+        GLCALL(glEnableVertexAttribArray(index));
+
+        if constexpr (sizeof...(Arrays) > 0) {
+            _stream_data<_Types...>(stream, index + 1, arrays...);
+        }
+    }
 public:
     VertexArray() {
         glGenVertexArrays(1, &vao_id);
@@ -74,51 +172,168 @@ public:
         std::swap(this->vao_id, rhs.vao_id);
         std::swap(this->vbo_id, rhs.vbo_id);
         std::swap(this->ebo_id, rhs.ebo_id);
+        std::swap(this->instance_vbo_id, rhs.instance_vbo_id);
+        std::swap(this->instance_source, rhs.instance_source);
+        std::swap(this->vertex_count, rhs.vertex_count);
+        std::swap(this->instance_attributes, rhs.instance_attributes);
+        std::swap(this->instance_stride, rhs.instance_stride);
+        std::swap(this->instance_count, rhs.instance_count);
+        std::swap(this->instance_capacity, rhs.instance_capacity);
     }
 
     void operator=(const VertexArray &rhs) = delete;
     void operator=(VertexArray &&rhs) = delete;
 
     ~VertexArray() {
+        auto &cache = StateCache::get();
+        cache.forget_vertex_array(vao_id);
+        cache.forget_buffer(vbo_id);
+        cache.forget_buffer(ebo_id);
+
         glDeleteVertexArrays(1, &vao_id);
         glDeleteBuffers(1, &vbo_id);
         glDeleteBuffers(1, &ebo_id);
+
+        if (instance_vbo_id > 0) {
+            cache.forget_buffer(instance_vbo_id);
+            glDeleteBuffers(1, &instance_vbo_id);
+        }
     }
 
     VertexArray<Types...> &set_indices(const std::vector<unsigned int> &indices) {
-        glBindVertexArray(vao_id);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id);
+        auto &cache = StateCache::get();
+        cache.bind_vertex_array(vao_id);
+        cache.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id);
 
         GLCALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
                 &indices[0], GL_STATIC_DRAW));
         this->vertex_count = indices.size();
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
         return *this;
     }
 
     template <typename... Arrays>
         requires (sizeof...(Types) == sizeof...(Arrays))
     VertexArray<Types...> &set_data(Arrays... arrays) {
-        glBindVertexArray(vao_id);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+        auto &cache = StateCache::get();
+        cache.bind_vertex_array(vao_id);
+        cache.bind_buffer(GL_ARRAY_BUFFER, vbo_id);
 
         std::size_t buffer_size_bytes = _calculate_total_array_size(arrays...);
         glBufferData(GL_ARRAY_BUFFER, buffer_size_bytes, nullptr, GL_STATIC_DRAW);
+        offset = 0;
+        attrib_index = 0;
         _set_data<Types...>(arrays...);
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
         return *this;
     }
 
+    // Geometry rewritten every frame: the arrays, each convertible to a
+    // `std::span<const float>`, go to this frame's region of `stream` and the vertex
+    // attributes point there until the next `set_data`
+    template <typename... Arrays>
+        requires (sizeof...(Types) == sizeof...(Arrays))
+    VertexArray<Types...> &set_data(StreamBuffer &stream, const Arrays &...arrays) {
+        auto &cache = StateCache::get();
+        cache.bind_vertex_array(vao_id);
+        cache.bind_buffer(GL_ARRAY_BUFFER, stream.get_id());
+        _stream_data<Types...>(stream, 0, arrays...);
+
+        return *this;
+    }
+
+    // Give every instance attributes of `InstanceTypes`, in that order and packed
+    // together, so an instance is laid out like a struct of those members. They take
+    // the attribute locations after the vertex attributes, matrices one per column.
+    template <typename... InstanceTypes>
+        requires (sizeof...(InstanceTypes) > 0)
+    VertexArray<Types...> &set_instance_layout() {
+        if (instance_vbo_id == 0) {
+            GLCALL(glGenBuffers(1, &instance_vbo_id));
+        }
+
+        instance_attributes.clear();
+        instance_stride = 0;
+        std::uint32_t location = sizeof...(Types);
+        (add_instance_attribute<InstanceTypes>(location), ...);
+
+        point_instance_attributes(instance_vbo_id, 0);
+        for (const auto &attribute : instance_attributes) {
+            GLCALL(glVertexAttribDivisor(attribute.location, 1));
+            GLCALL(glEnableVertexAttribArray(attribute.location));
+        }
+
+        return *this;
+    }
+
+    virtual void set_instance_data(const void *data, std::size_t bytes, std::size_t count) override {
+        check_instance_data(bytes, count);
+
+        if (instance_source != instance_vbo_id) {
+            point_instance_attributes(instance_vbo_id, 0);
+        }
+
+        StateCache::get().bind_buffer(GL_ARRAY_BUFFER, instance_vbo_id);
+        if (bytes > instance_capacity) {
+            instance_capacity = bytes;
+            GLCALL(glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STREAM_DRAW));
+        } else if (bytes > 0) {
+            // orphan the old storage so a draw still reading it doesn't stall the upload
+            GLCALL(glBufferData(GL_ARRAY_BUFFER, instance_capacity, nullptr, GL_STREAM_DRAW));
+            GLCALL(glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data));
+        }
+
+        instance_count = count;
+    }
+
+    // The instances stay valid for this frame only, the region is reused `frames`
+    // frames later
+    virtual void set_instance_data(StreamBuffer &stream, const void *data, std::size_t bytes, std::size_t count) override {
+        check_instance_data(bytes, count);
+
+        auto allocation = stream.write(data, bytes, sizeof(float));
+        point_instance_attributes(stream.get_id(), allocation.offset);
+        instance_count = count;
+    }
+
+    template <typename Instance>
+    VertexArray<Types...> &set_instances(std::span<const Instance> instances) {
+        set_instance_data(instances.data(), instances.size_bytes(), instances.size());
+        return *this;
+    }
+
+    template <typename Instance>
+    VertexArray<Types...> &set_instances(StreamBuffer &stream, std::span<const Instance> instances) {
+        set_instance_data(stream, instances.data(), instances.size_bytes(), instances.size());
+        return *this;
+    }
+
+    // Leaves the program and vertex array bound, see `StateCache`
     virtual void draw(const Program &program) override {
-        GLCALL(glUseProgram(program));
-        GLCALL(glBindVertexArray(vao_id));
+        auto &cache = StateCache::get();
+        cache.use_program(program);
+        cache.bind_vertex_array(vao_id);
         GLCALL(glDrawElements(GL_TRIANGLES, this->vertex_count, GL_UNSIGNED_INT, 0));
-        GLCALL(glBindVertexArray(0));
+    }
+
+    // Draw the first `instances` instances set with `set_instance_data`
+    virtual void draw_instanced(const Program &program, std::size_t instances) override {
+        auto &cache = StateCache::get();
+        cache.use_program(program);
+        cache.bind_vertex_array(vao_id);
+        GLCALL(glDrawElementsInstanced(GL_TRIANGLES, this->vertex_count, GL_UNSIGNED_INT, 0, instances));
+    }
+
+    virtual vao_t get_id() const noexcept override {
+        return vao_id;
+    }
+
+    virtual std::size_t get_index_count() const noexcept override {
+        return vertex_count;
+    }
+
+    virtual std::size_t get_instance_count() const noexcept override {
+        return instance_count;
     }
 };
 
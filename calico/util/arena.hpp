@@ -0,0 +1,78 @@
+#ifndef _CALICO_ARENA_HPP_
+#define _CALICO_ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Calico {
+
+// Bump allocator handing out memory from a list of blocks. Individual allocations
+// are never freed; `reset` rewinds the arena while keeping its blocks, so an arena
+// reused every frame stops allocating once it has grown to the frame's peak usage.
+// Nothing allocated in an arena is destroyed by it.
+class Arena {
+    static constexpr std::size_t Default_Block_Bytes = 64 * 1024;
+
+    struct BlockDeleter {
+        void operator()(std::byte *memory) const {
+            ::operator delete[](memory, std::align_val_t(alignof(std::max_align_t)));
+        }
+    };
+
+    struct Block {
+        std::unique_ptr<std::byte[], BlockDeleter> memory;
+        std::size_t bytes = 0;
+    };
+
+    std::vector<Block> blocks = {};
+    std::size_t block_bytes = Default_Block_Bytes;
+    std::size_t current = 0;
+    std::size_t used = 0;
+public:
+    explicit Arena(std::size_t block_bytes = Default_Block_Bytes) : block_bytes(block_bytes) {}
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        while (current < blocks.size()) {
+            auto base = reinterpret_cast<std::uintptr_t>(blocks[current].memory.get());
+            std::size_t offset = ((base + used + alignment - 1) & ~(alignment - 1)) - base;
+            if (offset + bytes <= blocks[current].bytes) {
+                used = offset + bytes;
+                return blocks[current].memory.get() + offset;
+            }
+
+            current++;
+            used = 0;
+        }
+
+        // allocations larger than a block get a block of their own
+        std::size_t size = std::max(bytes + alignment, block_bytes);
+        blocks.push_back({
+            std::unique_ptr<std::byte[], BlockDeleter>(
+                new (std::align_val_t(alignof(std::max_align_t))) std::byte[size]),
+            size
+        });
+
+        current = blocks.size() - 1;
+        used = 0;
+        return allocate(bytes, alignment);
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept {
+        current = 0;
+        used = 0;
+    }
+};
+
+}
+
+#endif // _CALICO_ARENA_HPP_
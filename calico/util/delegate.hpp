@@ -0,0 +1,103 @@
+#ifndef _CALICO_DELEGATE_HPP_
+#define _CALICO_DELEGATE_HPP_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Calico {
+
+template <typename Signature>
+class Delegate;
+
+// Non-owning callable the size of three pointers: a member function bound to an
+// object, a free function, or a small trivially copyable function object such as a
+// lambda capturing `this`. Never allocates, and calling it is a single indirect call
+// to a stub that knows the target's type.
+//
+// A delegate bound to an object doesn't keep the object alive, so it must not be
+// called after the object is destroyed.
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+public:
+    static constexpr std::size_t Storage_Bytes = 2 * sizeof(void*);
+private:
+    using Stub = R (*)(const void *storage, Args... args);
+
+    alignas(void*) std::byte storage[Storage_Bytes] = {};
+    Stub stub = nullptr;
+public:
+    Delegate() = default;
+
+    // Wrap a function object, which is copied into the delegate
+    template <typename Fn>
+        requires (!std::is_same_v<std::remove_cvref_t<Fn>, Delegate>
+            && std::is_invocable_r_v<R, const Fn&, Args...>)
+    Delegate(Fn fn) noexcept {
+        static_assert(std::is_trivially_copyable_v<Fn>, "Delegate targets must be trivially copyable");
+        static_assert(sizeof(Fn) <= Storage_Bytes, "Delegate target too large, capture less");
+        static_assert(alignof(Fn) <= alignof(void*), "Delegate target over-aligned");
+
+        new (storage) Fn(fn);
+        stub = [](const void *storage, Args... args) -> R {
+            return (*std::launder(reinterpret_cast<const Fn*>(storage)))(std::forward<Args>(args)...);
+        };
+    }
+
+    // Call `(object->*Method)(args...)`
+    template <auto Method, typename T>
+    static Delegate bind(T *object) noexcept {
+        Delegate delegate;
+        new (delegate.storage) T*(object);
+        delegate.stub = [](const void *storage, Args... args) -> R {
+            T *object = *std::launder(reinterpret_cast<T* const*>(storage));
+            return (object->*Method)(std::forward<Args>(args)...);
+        };
+
+        return delegate;
+    }
+
+    // Call `Function(args...)`
+    template <auto Function>
+    static Delegate bind() noexcept {
+        Delegate delegate;
+        delegate.stub = [](const void*, Args... args) -> R {
+            return Function(std::forward<Args>(args)...);
+        };
+
+        return delegate;
+    }
+
+    R operator()(Args... args) const {
+        return stub(storage, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return stub != nullptr;
+    }
+};
+
+template <typename Method>
+struct MemberFunctionSignature;
+
+template <typename T, typename R, typename... Args>
+struct MemberFunctionSignature<R (T::*)(Args...)> {
+    using type = R(Args...);
+};
+
+template <typename T, typename R, typename... Args>
+struct MemberFunctionSignature<R (T::*)(Args...) const> {
+    using type = R(Args...);
+};
+
+// Bind a member function to `object`, taking the delegate's signature from the
+// function: `delegate<&Player::on_key_down>(this)`
+template <auto Method, typename T>
+auto delegate(T *object) noexcept {
+    return Delegate<typename MemberFunctionSignature<decltype(Method)>::type>::template bind<Method>(object);
+}
+
+}
+
+#endif // _CALICO_DELEGATE_HPP_
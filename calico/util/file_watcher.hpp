@@ -0,0 +1,151 @@
+#ifndef _CALICO_FILE_WATCHER_HPP_
+#define _CALICO_FILE_WATCHER_HPP_
+
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace Calico {
+
+// Reports files that changed on disk, without blocking.
+//
+// A file is only reported once it has stopped changing for `debounce`, so an editor
+// writing a file in several steps, or saving repeatedly, results in a single change.
+// On Linux the watcher uses inotify on the directories holding the watched files,
+// which also catches editors that save by replacing the file; elsewhere it compares
+// modification times on every `poll`.
+class FileWatcher {
+    using Clock = std::chrono::steady_clock;
+
+    std::chrono::milliseconds debounce;
+    std::set<std::filesystem::path> files = {};
+    // files that changed, with when they last changed
+    std::unordered_map<std::string, Clock::time_point> changed = {};
+
+#ifdef __linux__
+    int inotify = -1;
+    // directory watched by each inotify watch descriptor
+    std::unordered_map<int, std::filesystem::path> directories = {};
+
+    void read_changes() {
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = read(inotify, buffer, sizeof(buffer));
+            if (length <= 0) {
+                // EAGAIN once every pending event has been read
+                return;
+            }
+
+            for (ssize_t offset = 0; offset < length; ) {
+                auto *event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0) {
+                    continue;
+                }
+
+                auto file = directory->second / event->name;
+                if (files.contains(file)) {
+                    changed[file.string()] = Clock::now();
+                }
+            }
+        }
+    }
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> write_times = {};
+
+    static std::filesystem::file_time_type write_time(const std::filesystem::path &file) {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(file, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+
+    void read_changes() {
+        for (const auto &file : files) {
+            auto time = write_time(file);
+            auto &last = write_times[file.string()];
+            if (time != last) {
+                last = time;
+                changed[file.string()] = Clock::now();
+            }
+        }
+    }
+#endif // __linux__
+public:
+    explicit FileWatcher(std::chrono::milliseconds debounce = std::chrono::milliseconds(150))
+        : debounce(debounce) {
+#ifdef __linux__
+        inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify < 0) {
+            throw std::runtime_error("Unable to initialize inotify");
+        }
+#endif // __linux__
+    }
+
+    FileWatcher(const FileWatcher &rhs) = delete;
+    void operator=(const FileWatcher &rhs) = delete;
+
+    ~FileWatcher() {
+#ifdef __linux__
+        close(inotify);
+#endif // __linux__
+    }
+
+    // Start watching `path`. Watching a file twice does nothing.
+    void watch(const std::filesystem::path &path) {
+        auto file = std::filesystem::weakly_canonical(path);
+        if (!files.insert(file).second) {
+            return;
+        }
+
+#ifdef __linux__
+        auto directory = file.parent_path();
+        int descriptor = inotify_add_watch(inotify, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (descriptor < 0) {
+            files.erase(file);
+            throw std::runtime_error("Unable to watch '" + directory.string() + "'");
+        }
+
+        // the same descriptor is returned for a directory that is already watched
+        directories.insert({ descriptor, directory });
+#else
+        write_times[file.string()] = write_time(file);
+#endif // __linux__
+    }
+
+    // Files that changed since the last call and have been left alone for `debounce`
+    std::vector<std::string> poll() {
+        read_changes();
+
+        std::vector<std::string> settled;
+        auto now = Clock::now();
+        for (auto file = changed.begin(); file != changed.end(); ) {
+            if (now - file->second >= debounce) {
+                settled.push_back(file->first);
+                file = changed.erase(file);
+            } else {
+                file++;
+            }
+        }
+
+        return settled;
+    }
+};
+
+}
+
+#endif // _CALICO_FILE_WATCHER_HPP_
@@ -0,0 +1,109 @@
+#ifndef _CALICO_MAPPED_FILE_HPP_
+#define _CALICO_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace Calico {
+
+// Read-only view of a whole file. The file is mapped into memory where possible, so
+// opening it costs no copy and pages are only read as they are touched; otherwise it
+// is read into a buffer.
+class MappedFile {
+    const char *contents = nullptr;
+    std::size_t length = 0;
+    // holds the contents when the file couldn't be mapped
+    std::vector<char> buffer = {};
+
+    void release() noexcept {
+#ifndef _WIN32
+        if (contents && buffer.empty()) {
+            munmap(const_cast<char*>(contents), length);
+        }
+#endif // _WIN32
+
+        contents = nullptr;
+        length = 0;
+        buffer.clear();
+    }
+public:
+    // Throws `std::runtime_error` if the file can't be opened
+    explicit MappedFile(const std::string &path) {
+#ifndef _WIN32
+        int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            throw std::runtime_error("Unable to open '" + path + "'");
+        }
+
+        struct stat info;
+        bool empty = false;
+        if (fstat(file, &info) == 0) {
+            // mapping zero bytes fails, and there is nothing to read anyway
+            empty = info.st_size == 0;
+            if (!empty) {
+                void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+                if (mapping != MAP_FAILED) {
+                    contents = static_cast<const char*>(mapping);
+                    length = info.st_size;
+                }
+            }
+        }
+
+        close(file);
+
+        if (contents || empty) {
+            return;
+        }
+#endif // _WIN32
+
+        std::ifstream file_stream(path, std::ios::binary);
+        if (!file_stream) {
+            throw std::runtime_error("Unable to open '" + path + "'");
+        }
+
+        buffer.assign(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
+        contents = buffer.data();
+        length = buffer.size();
+    }
+
+    MappedFile(MappedFile &&rhs) noexcept
+        : contents(std::exchange(rhs.contents, nullptr)),
+          length(std::exchange(rhs.length, 0)),
+          buffer(std::move(rhs.buffer)) {}
+
+    MappedFile(const MappedFile &rhs) = delete;
+    void operator=(const MappedFile &rhs) = delete;
+
+    ~MappedFile() {
+        release();
+    }
+
+    const char *data() const noexcept {
+        return contents;
+    }
+
+    std::size_t size() const noexcept {
+        return length;
+    }
+
+    std::string_view view() const noexcept {
+        return { contents, length };
+    }
+};
+
+}
+
+#endif // _CALICO_MAPPED_FILE_HPP_
@@ -0,0 +1,135 @@
+#ifndef _CALICO_MPSC_QUEUE_HPP_
+#define _CALICO_MPSC_QUEUE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "parallel_for.hpp"
+
+namespace Calico {
+
+// Counters kept by an `MPSCQueue`
+struct QueueStats {
+    // values pushed successfully
+    std::size_t pushed = 0;
+    // values rejected because the queue was full
+    std::size_t dropped = 0;
+    // most values ever waiting in the queue at once
+    std::size_t high_water = 0;
+};
+
+// Bounded lock-free queue any number of threads may push to while a single thread
+// pops from it.
+//
+// Each cell carries a sequence number telling producers whether it is free to write
+// and the consumer whether it has been written, so producers only contend on claiming
+// a position and never wait on each other or on the consumer. Pushing to a full queue
+// fails instead of blocking and is counted in `stats().dropped`.
+template <
+    typename T,
+    std::size_t Capacity>
+class MPSCQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "Capacity must be a power of two");
+
+    static constexpr std::size_t Mask = Capacity - 1;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence = 0;
+        T value = {};
+    };
+
+    std::unique_ptr<Cell[]> cells = std::make_unique<Cell[]>(Capacity);
+
+    // producers and consumer each get their own cache line
+    alignas(Cache_Line_Bytes) std::atomic<std::size_t> enqueue_position = 0;
+    alignas(Cache_Line_Bytes) std::atomic<std::size_t> dequeue_position = 0;
+    alignas(Cache_Line_Bytes) std::atomic<std::size_t> dropped = 0;
+    std::atomic<std::size_t> high_water = 0;
+public:
+    MPSCQueue() {
+        for (std::size_t i = 0; i < Capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue &rhs) = delete;
+    void operator=(const MPSCQueue &rhs) = delete;
+
+    // Callable from any thread. Returns false without pushing if the queue is full.
+    bool try_push(const T &value) {
+        std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        while (true) {
+            cell = &cells[position & Mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (difference == 0) {
+                // the cell is free, claim it
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // the consumer hasn't freed the cell from the previous lap yet
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                // another producer claimed the cell first
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        // The consumer may already have drained past this cell, through cells other
+        // producers published later, leaving nothing to count
+        auto depth = static_cast<std::intptr_t>(position + 1)
+            - static_cast<std::intptr_t>(dequeue_position.load(std::memory_order_relaxed));
+        if (depth > 0) {
+            auto bounded = std::min(static_cast<std::size_t>(depth), Capacity);
+            std::size_t highest = high_water.load(std::memory_order_relaxed);
+            while (bounded > highest
+                && !high_water.compare_exchange_weak(highest, bounded, std::memory_order_relaxed)) {}
+        }
+
+        return true;
+    }
+
+    // Only callable from the consumer thread. Returns false if the queue is empty.
+    bool try_pop(T &value) {
+        std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+        Cell &cell = cells[position & Mask];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        value = std::move(cell.value);
+        cell.sequence.store(position + Capacity, std::memory_order_release);
+        dequeue_position.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Snapshot of the counters; only exact while no thread is pushing
+    QueueStats stats() const noexcept {
+        std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+        return {
+            .pushed = position,
+            .dropped = dropped.load(std::memory_order_relaxed),
+            .high_water = high_water.load(std::memory_order_relaxed),
+        };
+    }
+
+    static constexpr std::size_t capacity() noexcept {
+        return Capacity;
+    }
+};
+
+}
+
+#endif // _CALICO_MPSC_QUEUE_HPP_
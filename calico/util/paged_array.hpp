@@ -0,0 +1,118 @@
+#ifndef _CALICO_PAGED_ARRAY_HPP_
+#define _CALICO_PAGED_ARRAY_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Calico {
+
+// Growable array whose elements live in fixed-size pages allocated on demand.
+//
+// Unlike `std::vector`, growing never moves existing elements: a new page is
+// allocated and the others stay where they are, so references to elements stay valid
+// until the element itself is removed. Pages are aligned to and sized in multiples of
+// a cache line.
+template <
+    typename T,
+    std::size_t Page_Size = 1024>
+class PagedArray {
+    static constexpr std::size_t Page_Alignment = std::max<std::size_t>(64, alignof(T));
+
+    static_assert(Page_Size % 64 == 0, "Page_Size must be a multiple of 64 elements");
+
+    struct PageDeleter {
+        void operator()(T *page) const {
+            ::operator delete(page, std::align_val_t(Page_Alignment));
+        }
+    };
+
+    using Page = std::unique_ptr<T, PageDeleter>;
+
+    std::vector<Page> pages = {};
+    std::size_t count = 0;
+
+    T *slot(std::size_t index) const noexcept {
+        return pages[index / Page_Size].get() + index % Page_Size;
+    }
+
+    void allocate_page() {
+        pages.emplace_back(static_cast<T*>(
+            ::operator new(sizeof(T) * Page_Size, std::align_val_t(Page_Alignment))));
+    }
+public:
+    PagedArray() = default;
+    // Leaves `rhs` empty, without pages or elements
+    PagedArray(PagedArray &&rhs) noexcept : pages(std::move(rhs.pages)), count(std::exchange(rhs.count, 0)) {
+        rhs.pages.clear();
+    }
+
+    PagedArray(const PagedArray &rhs) = delete;
+    void operator=(const PagedArray &rhs) = delete;
+
+    ~PagedArray() {
+        clear();
+    }
+
+    T &operator[](std::size_t index) noexcept {
+        return *slot(index);
+    }
+
+    const T &operator[](std::size_t index) const noexcept {
+        return *slot(index);
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args&&... args) {
+        if (count == capacity()) {
+            allocate_page();
+        }
+
+        T *element = new (slot(count)) T(std::forward<Args>(args)...);
+        count++;
+        return *element;
+    }
+
+    void pop_back() {
+        count--;
+        slot(count)->~T();
+    }
+
+    void clear() {
+        while (count > 0) {
+            pop_back();
+        }
+    }
+
+    // Allocate pages for at least `n` elements up front
+    void reserve(std::size_t n) {
+        pages.reserve((n + Page_Size - 1) / Page_Size);
+        while (capacity() < n) {
+            allocate_page();
+        }
+    }
+
+    // Free the pages past the last element
+    void shrink_to_fit() {
+        pages.resize((count + Page_Size - 1) / Page_Size);
+    }
+
+    std::size_t size() const noexcept {
+        return count;
+    }
+
+    std::size_t capacity() const noexcept {
+        return pages.size() * Page_Size;
+    }
+
+    std::size_t allocated_bytes() const noexcept {
+        return pages.size() * Page_Size * sizeof(T) + pages.capacity() * sizeof(Page);
+    }
+};
+
+}
+
+#endif // _CALICO_PAGED_ARRAY_HPP_
@@ -0,0 +1,75 @@
+#ifndef _CALICO_PARALLEL_FOR_HPP_
+#define _CALICO_PARALLEL_FOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace Calico {
+
+constexpr std::size_t Cache_Line_Bytes = 64;
+
+// One value per thread of a `ThreadPool`, each on its own cache line so threads
+// writing to their own value don't contend. Used as scratch space or to accumulate
+// partial results inside parallel loops, then combined by iterating over all values.
+template <typename T>
+class PerThread {
+    struct alignas(Cache_Line_Bytes) Slot {
+        T value = {};
+    };
+
+    const ThreadPool *pool = nullptr;
+    std::vector<Slot> slots = {};
+public:
+    explicit PerThread(const ThreadPool &pool) : pool(&pool), slots(pool.concurrency()) {}
+
+    // The calling thread's value
+    T &local() noexcept {
+        return slots[pool->worker_index()].value;
+    }
+
+    template <typename Fn>
+    void for_each(Fn &&fn) {
+        for (auto &slot : slots) {
+            fn(slot.value);
+        }
+    }
+};
+
+// Call `fn(begin, end)` over consecutive chunks covering `[0, count)` on `pool` and
+// wait for all of them to finish.
+//
+// Chunk boundaries are multiples of `Cache_Line_Bytes` elements. Any array of elements
+// starting on a cache line therefore has each chunk start on a cache line as well, so
+// no two threads write to the same line. The range is split into several chunks per
+// thread so that threads finishing early can steal the remainder. `fn` must not throw.
+template <typename Fn>
+void parallel_for(ThreadPool &pool, std::size_t count, Fn &&fn) {
+    constexpr std::size_t Granularity = Cache_Line_Bytes;
+    constexpr std::size_t Chunks_Per_Thread = 4;
+
+    if (count == 0) {
+        return;
+    }
+
+    std::size_t chunk = count / (pool.concurrency() * Chunks_Per_Thread);
+    chunk = std::max(Granularity, (chunk + Granularity - 1) / Granularity * Granularity);
+
+    std::atomic<std::size_t> pending = (count + chunk - 1) / chunk;
+    for (std::size_t begin = 0; begin < count; begin += chunk) {
+        std::size_t end = std::min(begin + chunk, count);
+        pool.submit([&fn, &pending, begin, end] {
+            fn(begin, end);
+            pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    pool.wait(pending);
+}
+
+}
+
+#endif // _CALICO_PARALLEL_FOR_HPP_
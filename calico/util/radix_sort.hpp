@@ -0,0 +1,76 @@
+#ifndef _CALICO_RADIX_SORT_HPP_
+#define _CALICO_RADIX_SORT_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace Calico {
+
+// Stable least significant digit radix sort of `items` by the 64-bit key `key(item)`
+// returns, a byte at a time. `scratch` must be at least as large as `items`, or this
+// throws, and is left holding garbage; keeping it around between sorts avoids
+// allocating.
+//
+// The key histograms for all bytes are built in one pass over the items, and bytes
+// that are the same for every key are skipped, so keys that only use their low bits,
+// or share their high bits, take fewer passes. Sorts in O(n) for any key distribution,
+// which beats comparison sorts once there are more than a few hundred items.
+template <typename T, typename KeyFn>
+void radix_sort(std::span<T> items, std::span<T> scratch, KeyFn &&key) {
+    constexpr std::size_t Digits = sizeof(std::uint64_t);
+    constexpr std::size_t Radix = 256;
+
+    if (scratch.size() < items.size()) {
+        throw std::runtime_error("Radix sort scratch buffer is smaller than the items");
+    } else if (items.size() < 2) {
+        return;
+    }
+
+    std::array<std::array<std::size_t, Radix>, Digits> counts = {};
+    for (const T &item : items) {
+        std::uint64_t k = key(item);
+        for (std::size_t digit = 0; digit < Digits; digit++) {
+            counts[digit][(k >> (digit * 8)) & 0xff]++;
+        }
+    }
+
+    T *source = items.data();
+    T *destination = scratch.data();
+
+    for (std::size_t digit = 0; digit < Digits; digit++) {
+        auto &count = counts[digit];
+
+        // every key has the same byte here, nothing would move
+        std::uint64_t first_byte = (key(source[0]) >> (digit * 8)) & 0xff;
+        if (count[first_byte] == items.size()) {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (auto &bucket : count) {
+            offset += std::exchange(bucket, offset);
+        }
+
+        for (std::size_t i = 0; i < items.size(); i++) {
+            std::size_t byte = (key(source[i]) >> (digit * 8)) & 0xff;
+            destination[count[byte]++] = std::move(source[i]);
+        }
+
+        std::swap(source, destination);
+    }
+
+    // an odd number of passes leaves the result in the scratch buffer
+    if (source != items.data()) {
+        for (std::size_t i = 0; i < items.size(); i++) {
+            items[i] = std::move(source[i]);
+        }
+    }
+}
+
+}
+
+#endif // _CALICO_RADIX_SORT_HPP_
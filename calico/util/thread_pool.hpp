@@ -0,0 +1,205 @@
+#ifndef _CALICO_THREAD_POOL_HPP_
+#define _CALICO_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Calico {
+
+// Work-stealing thread pool.
+//
+// Every worker owns a queue it pushes to and pops from at the back, so tasks spawned by
+// a task run on the same core while their data is still in cache. Idle workers steal
+// from the front of other queues. Threads outside the pool share queue 0.
+//
+// Waiting is cooperative: `wait` runs queued tasks on the calling thread until the
+// awaited counter drops to zero, so tasks may themselves submit and wait on more work
+// without deadlocking the pool.
+//
+// Blocking work nobody waits on, like reading files, goes to `submit_background`. Only
+// workers run it, once their own and stolen tasks run out, so it never holds up a
+// thread inside `wait`.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues = {};
+    Queue background;
+    std::vector<std::thread> workers = {};
+    // may briefly go negative when a task is taken before its submitter counts it
+    std::atomic<std::ptrdiff_t> queued = 0;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    inline static thread_local const ThreadPool *current_pool = nullptr;
+    inline static thread_local std::size_t current_index = 0;
+
+    bool pop(std::size_t index, Task &task) {
+        auto &queue = *queues[index];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(std::size_t index, Task &task) {
+        auto &queue = *queues[index];
+        std::unique_lock lock(queue.mutex, std::try_to_lock);
+        if (!lock || queue.tasks.empty()) {
+            return false;
+        }
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    bool find_task(Task &task) {
+        std::size_t own = worker_index();
+
+        if (pop(own, task)) {
+            return true;
+        }
+
+        for (std::size_t i = 1; i < queues.size(); i++) {
+            if (steal((own + i) % queues.size(), task)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool find_background_task(Task &task) {
+        std::lock_guard lock(background.mutex);
+        if (background.tasks.empty()) {
+            return false;
+        }
+
+        task = std::move(background.tasks.front());
+        background.tasks.pop_front();
+        return true;
+    }
+
+    void push(Queue &queue, Task &&task) {
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        {
+            std::lock_guard lock(sleep_mutex);
+            queued++;
+        }
+
+        wake.notify_one();
+    }
+
+    void run_worker(std::size_t index) {
+        current_pool = this;
+        current_index = index;
+
+        Task task;
+        while (true) {
+            if (find_task(task) || find_background_task(task)) {
+                queued--;
+                task();
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued <= 0) {
+                return;
+            }
+        }
+    }
+public:
+    // Spawn `threads` workers. The threads calling `wait` also run tasks, so the
+    // default leaves one core for the caller.
+    explicit ThreadPool(std::size_t threads = std::max(std::thread::hardware_concurrency(), 2u) - 1) {
+        for (std::size_t i = 0; i <= threads; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+
+        for (std::size_t i = 1; i <= threads; i++) {
+            workers.emplace_back(&ThreadPool::run_worker, this, i);
+        }
+    }
+
+    ThreadPool(const ThreadPool &rhs) = delete;
+    void operator=(const ThreadPool &rhs) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(sleep_mutex);
+            stopping = true;
+        }
+
+        wake.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Number of threads which can run tasks at once: the workers plus the thread
+    // waiting on them
+    std::size_t concurrency() const noexcept {
+        return queues.size();
+    }
+
+    // Index of the calling thread within this pool. Workers are numbered from 1 and
+    // every other thread is 0, so the result can index per-thread storage with
+    // `concurrency()` slots.
+    std::size_t worker_index() const noexcept {
+        return current_pool == this ? current_index : 0;
+    }
+
+    void submit(Task &&task) {
+        push(*queues[worker_index()], std::move(task));
+    }
+
+    // Run `task` on a worker, never inside `wait`. Background tasks start in the order
+    // they were submitted. A pool without workers runs them as ordinary tasks.
+    void submit_background(Task &&task) {
+        if (workers.empty()) {
+            submit(std::move(task));
+        } else {
+            push(background, std::move(task));
+        }
+    }
+
+    // Run queued tasks on the calling thread until `pending` reaches zero
+    void wait(const std::atomic<std::size_t> &pending) {
+        Task task;
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (find_task(task)) {
+                queued--;
+                task();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+}
+
+#endif // _CALICO_THREAD_POOL_HPP_
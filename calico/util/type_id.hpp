@@ -0,0 +1,39 @@
+#ifndef _CALICO_TYPE_ID_HPP_
+#define _CALICO_TYPE_ID_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace Calico {
+
+// Numbers types consecutively from 0 in the order they are first asked about, so
+// per-type storage can live in an array indexed by the type's id rather than in a map
+// keyed by `typeid`. Each `Family` tag has its own numbering, keeping ids of unrelated
+// kinds of types (components, assets, ...) small and dense.
+//
+// Ids are stable for the lifetime of the process but may differ between runs.
+template <typename Family>
+class TypeFamily {
+    inline static std::atomic<std::size_t> next_id = 0;
+
+    template <typename T>
+    static std::size_t assign() noexcept {
+        static const std::size_t value = next_id.fetch_add(1, std::memory_order_relaxed);
+        return value;
+    }
+public:
+    template <typename T>
+    static std::size_t id() noexcept {
+        return assign<std::remove_cvref_t<T>>();
+    }
+
+    // Number of ids handed out so far
+    static std::size_t count() noexcept {
+        return next_id.load(std::memory_order_relaxed);
+    }
+};
+
+}
+
+#endif // _CALICO_TYPE_ID_HPP_
@@ -3,10 +3,50 @@
 
 #include <cstdint>
 #include <cmath>
+#include <compare>
+#include <functional>
+
+// Handle to an entity: the index of the entity's slot in the ECS tables, plus the
+// generation of that slot when the handle was created. Slots get a new generation
+// each time they are freed, so a handle to a deleted entity never compares equal to
+// a handle to whichever entity reuses its slot.
+struct Entity {
+    // 4M live entities, each slot reusable 1024 times before handles can collide
+    static constexpr std::uint32_t Index_Bits = 22;
+    static constexpr std::uint32_t Index_Mask = (1u << Index_Bits) - 1;
+    static constexpr std::uint32_t Generation_Mask = ~0u >> Index_Bits;
+
+    // all ones, which is never handed out as the index of a live entity
+    std::uint32_t id = ~0u;
+
+    constexpr Entity() = default;
+    constexpr Entity(std::uint32_t index, std::uint32_t generation)
+        : id(((generation & Generation_Mask) << Index_Bits) | (index & Index_Mask)) {}
+
+    constexpr std::uint32_t index() const noexcept {
+        return id & Index_Mask;
+    }
+
+    constexpr std::uint32_t generation() const noexcept {
+        return id >> Index_Bits;
+    }
+
+    constexpr bool is_null() const noexcept {
+        return id == ~0u;
+    }
+
+    constexpr auto operator<=>(const Entity &rhs) const = default;
+};
+
+template <>
+struct std::hash<Entity> {
+    std::size_t operator()(const Entity &entity) const noexcept {
+        return std::hash<std::uint32_t>()(entity.id);
+    }
+};
 
-using Entity = std::uint16_t;
 using ComponentID = std::uint16_t;
-using Index = std::uint16_t;
+using Index = std::uint32_t;
 
 struct Vec3f {
     float x;
@@ -1,14 +1,55 @@
-#include <vector>
-#include <cstring>
-#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <optional>
 
 #include "xml/parsers.hpp"
+#include "xml/pull_parser.hpp"
 #include "logger/logger.hpp"
-
-#include "thirdparty/tinyxml/tinyxml.h"
+#include "util/mapped_file.hpp"
 
 using namespace Calico;
 
+using Token = XML::PullParser::Token;
+
+static MappedFile open_descriptor(const std::string &filename, const char *kind) {
+    try {
+        return MappedFile(filename);
+    } catch (const std::runtime_error &) {
+        throw XML::ParserError(std::string("Unable to open ") + kind + " '" + filename + "'");
+    }
+}
+
+// Move to the root element, which must be called `name`
+static void expect_root(XML::PullParser &parser, std::string_view name) {
+    if (parser.next() != Token::StartElement || parser.name() != name) {
+        parser.error("Expected a <" + std::string(name) + "> root element");
+    }
+}
+
+// Call `on_child` for each child element of the element just started, with the parser
+// at the child's start. `on_child` must consume the child up to and including its end.
+template <typename F>
+static void for_each_child(XML::PullParser &parser, F &&on_child) {
+    while (true) {
+        switch (parser.next()) {
+        case Token::StartElement: on_child(); break;
+        case Token::EndElement: return;
+        case Token::Text: parser.error("Unexpected text in <" + std::string(parser.name()) + ">");
+        case Token::End: return;
+        }
+    }
+}
+
+static float parse_float(XML::PullParser &parser, std::string_view text) {
+    float value = 0.0f;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        parser.error("Expected a float, got '" + std::string(text) + "'");
+    }
+
+    return value;
+}
+
 // <?xml version="1.0" encoding="UTF-8"?>
 // <material name="default_mat">
 //     <shader name="default_shader"/>
@@ -20,36 +61,31 @@ using namespace Calico;
 //     </properties>
 // </material>
 
-static std::vector<float> parse_float_array(const std::string &array_string, std::size_t elements) {
-    std::vector<float> floats;
-    floats.reserve(elements);
-
-    for (std::size_t lhs_index = 0ull; lhs_index < array_string.size(); ) {
-        std::size_t rhs_index = array_string.find(",", lhs_index);
+static void copy_floats(XML::PullParser &parser, std::string_view property_string,
+    MaterialDescriptor::Property &property, std::size_t n) {
 
-        // last element in the list of floats
-        if (rhs_index == std::string::npos) {
-            rhs_index = array_string.size() - 1;
+    // copying into the largest container of floats in property since it's just a union
+    std::size_t count = 0;
+    for (std::size_t lhs_index = 0; lhs_index <= property_string.size(); ) {
+        std::size_t rhs_index = std::min(property_string.find(',', lhs_index), property_string.size());
+        if (count == n) {
+            parser.error("Too many floats in array, expected " + std::to_string(n));
         }
 
-        floats.push_back(std::stod(array_string.substr(lhs_index, rhs_index)));
+        auto element = property_string.substr(lhs_index, rhs_index - lhs_index);
+        element.remove_prefix(std::min(element.find_first_not_of(" \t\r\n"), element.size()));
+        element.remove_suffix(element.size() - std::min(element.find_last_not_of(" \t\r\n") + 1, element.size()));
+
+        property.mat4[count++] = parse_float(parser, element);
         lhs_index = rhs_index + 1;
     }
 
-    return floats;
-}
-
-static void copy_floats(const std::string &property_string, MaterialDescriptor::Property &property, std::size_t n) {
-    auto floats = parse_float_array(property_string, n);
-    if (floats.size() != n || floats.size() > sizeof(property.mat4) / sizeof(float)) {
-        throw XML::ParserError("Error parsing float array in material descriptor");
+    if (count != n) {
+        parser.error("Too few floats in array, expected " + std::to_string(n));
     }
-
-    // copying into the largest container of floats in property since it's just a union
-    std::copy(floats.begin(), floats.begin() + n, property.mat4);
 }
 
-static std::optional<MaterialDescriptor::PropertyType> parse_property_type(const std::string &type) {
+static std::optional<MaterialDescriptor::PropertyType> parse_property_type(std::string_view type) {
     if (type == "float") {
         return MaterialDescriptor::PropertyType::Float;
     } else if (type == "bool") {
@@ -73,69 +109,67 @@ static std::optional<MaterialDescriptor::PropertyType> parse_property_type(const
     return std::nullopt;
 }
 
-static std::optional<MaterialDescriptor::Property> parse_material_property(
-    std::optional<MaterialDescriptor::PropertyType> type, const std::string &property_string) {
+static MaterialDescriptor::Property parse_material_property(XML::PullParser &parser,
+    MaterialDescriptor::PropertyType type, std::string_view property_string) {
 
     MaterialDescriptor::Property property;
 
-    if (!type) {
-        return std::nullopt;
-    }
-
-    switch (type.value()) {
-    case MaterialDescriptor::PropertyType::Float: property.f = std::stod(property_string); break;
-    case MaterialDescriptor::PropertyType::Bool: property.b = (property_string == "true" ? true : false); break;
-    case MaterialDescriptor::PropertyType::Vec2: copy_floats(property_string, property, 2); break;
-    case MaterialDescriptor::PropertyType::Vec3: copy_floats(property_string, property, 3); break;
-    case MaterialDescriptor::PropertyType::Vec4: copy_floats(property_string, property, 4); break;
-    case MaterialDescriptor::PropertyType::Mat2: copy_floats(property_string, property, 4); break;
-    case MaterialDescriptor::PropertyType::Mat3: copy_floats(property_string, property, 9); break;
-    case MaterialDescriptor::PropertyType::Mat4: copy_floats(property_string, property, 16); break;
-    default: return std::nullopt;
+    switch (type) {
+    case MaterialDescriptor::PropertyType::Float: property.f = parse_float(parser, property_string); break;
+    case MaterialDescriptor::PropertyType::Bool: property.b = property_string == "true"; break;
+    case MaterialDescriptor::PropertyType::Vec2: copy_floats(parser, property_string, property, 2); break;
+    case MaterialDescriptor::PropertyType::Vec3: copy_floats(parser, property_string, property, 3); break;
+    case MaterialDescriptor::PropertyType::Vec4: copy_floats(parser, property_string, property, 4); break;
+    case MaterialDescriptor::PropertyType::Mat2: copy_floats(parser, property_string, property, 4); break;
+    case MaterialDescriptor::PropertyType::Mat3: copy_floats(parser, property_string, property, 9); break;
+    case MaterialDescriptor::PropertyType::Mat4: copy_floats(parser, property_string, property, 16); break;
     }
 
     return property;
 }
 
-MaterialDescriptor XML::read_material(const std::string &filename) {
+MaterialDescriptor XML::parse_material(std::string_view document, const std::string &source) {
     MaterialDescriptor material;
-    TiXmlDocument matl_description(filename.c_str());
-
-    if (matl_description.LoadFile()) {
-        TiXmlHandle handle(&matl_description);
-        TiXmlElement *element;
-        TiXmlHandle root(0);
-
-        element = handle.FirstChildElement().Element();
-        root = TiXmlHandle(element);
-
-        material.name = element->Attribute("name");
-
-        element = root.FirstChild("shader").Element();
-        material.shader = element->Attribute("name");
-
-        element = root.FirstChild("properties").FirstChild().Element();
-        for(; element != nullptr; element = element->NextSiblingElement()) {
-            const char *name = element->Attribute("name");
-            const char *type = element->Attribute("type");
-            const char *data = element->GetText();
-
-            auto property_type = parse_property_type(type);
-            auto property = parse_material_property(property_type, data);
-            if (property) {
-                material.add_property(name, property_type.value(), std::move(property.value()));
-            } else {
-                auto logger = Logger::get();
-                logger->log(Logger::Level::Warning, "Failed to add property");
-            }
+    PullParser parser(document, source);
+
+    expect_root(parser, "material");
+    material.name = parser.required_attribute("name");
+
+    for_each_child(parser, [&] {
+        if (parser.name() == "shader") {
+            material.shader = parser.required_attribute("name");
+            parser.skip_element();
+        } else if (parser.name() == "properties") {
+            for_each_child(parser, [&] {
+                if (parser.name() != "property") {
+                    parser.skip_element();
+                    return;
+                }
+
+                std::string name(parser.required_attribute("name"));
+                auto type = parse_property_type(parser.required_attribute("type"));
+                auto data = parser.read_text();
+
+                if (type) {
+                    material.add_property(name, type.value(), parse_material_property(parser, type.value(), data));
+                } else {
+                    Logger::get().log(Logger::Level::Warning, "Failed to add property '%s' to material '%s'",
+                        name.c_str(), material.name.c_str());
+                }
+            });
+        } else {
+            parser.skip_element();
         }
-    } else {
-        throw XML::ParserError("Unable to open material descriptor '" + filename + "'");
-    }
+    });
 
     return material;
 }
 
+MaterialDescriptor XML::read_material(const std::string &filename) {
+    auto file = open_descriptor(filename, "material descriptor");
+    return parse_material(file.view(), filename);
+}
+
 // <?xml version="1.0" encoding="UTF-8"?>
 // <program name="default_program" version="410 core">
 //     <shaders>
@@ -155,23 +189,73 @@ MaterialDescriptor XML::read_material(const std::string &filename) {
 //     </uniforms>
 // </program>
 
-ProgramDescriptor XML::read_program(const std::string &filename) {
-    ProgramDescriptor program;
-    TiXmlDocument program_description(filename.c_str());
+static std::optional<ProgramDescriptor::ShaderType> parse_shader_type(std::string_view type) {
+    if (type == "vertex") {
+        return ProgramDescriptor::ShaderType::Vertex;
+    } else if (type == "fragment") {
+        return ProgramDescriptor::ShaderType::Fragment;
+    } else if (type == "geometry") {
+        return ProgramDescriptor::ShaderType::Geometry;
+    }
 
-    if (program_description.LoadFile()) {
-        TiXmlHandle handle(&program_description);
-        TiXmlElement *element;
-        TiXmlHandle root(0);
+    return std::nullopt;
+}
 
-        element = handle.FirstChildElement().Element();
-        root = TiXmlHandle(element);
+// Call `on_item` with the parser at the start of each child of the element just started
+// called `item`, which must be the only kind of child
+template <typename F>
+static void for_each_item(XML::PullParser &parser, std::string_view item, F &&on_item) {
+    std::string_view list = parser.name();
+    for_each_child(parser, [&] {
+        if (parser.name() != item) {
+            parser.error("Unexpected <" + std::string(parser.name()) + "> in <" + std::string(list) + ">");
+        }
 
-        program.name = element->Attribute("name");
-        // TODO incomplete
-    } else {
-        throw XML::ParserError("Unable to open GLSL program descriptor '" + filename + "'");
-    }
+        on_item();
+    });
+}
+
+ProgramDescriptor XML::parse_program(std::string_view document, const std::string &source) {
+    ProgramDescriptor program;
+    PullParser parser(document, source);
+
+    expect_root(parser, "program");
+    program.name = parser.required_attribute("name");
+
+    for_each_child(parser, [&] {
+        if (parser.name() == "shaders") {
+            for_each_item(parser, "shader", [&] {
+                auto type = parse_shader_type(parser.required_attribute("type"));
+                if (!type) {
+                    parser.error("Unknown shader type '" + std::string(*parser.attribute("type")) + "'");
+                }
+
+                auto path = parser.read_text();
+                if (path.empty()) {
+                    parser.error("Shader without a source file");
+                }
+
+                program.shader_to_type.insert({ std::string(path), type.value() });
+            });
+        } else if (parser.name() == "uniform-buffers") {
+            for_each_item(parser, "buffer", [&] {
+                program.uniform_buffers.emplace_back(parser.read_text());
+            });
+        } else if (parser.name() == "uniforms") {
+            for_each_item(parser, "uniform", [&] {
+                std::string type(parser.required_attribute("type"));
+                program.uniforms.insert({ std::string(parser.read_text()), std::move(type) });
+            });
+        } else {
+            // the vertex layout comes from the shaders themselves
+            parser.skip_element();
+        }
+    });
 
     return program;
 }
+
+ProgramDescriptor XML::read_program(const std::string &filename) {
+    auto file = open_descriptor(filename, "GLSL program descriptor");
+    return parse_program(file.view(), filename);
+}
@@ -2,7 +2,10 @@
 #define __CALICO_XML_PARSERS_HPP__
 
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include "asset/asset_loader.hpp"
 #include "asset/material.hpp"
 #include "asset/program.hpp"
 #include "logger/errors.hpp"
@@ -17,6 +20,56 @@ public:
 Calico::MaterialDescriptor read_material(const std::string &filename);
 Calico::ProgramDescriptor read_program(const std::string &filename);
 
+// Parse a descriptor already in memory, `source` names it in error messages
+Calico::MaterialDescriptor parse_material(std::string_view document, const std::string &source);
+Calico::ProgramDescriptor parse_program(std::string_view document, const std::string &source);
+
+}
+
+namespace Calico {
+
+template <>
+struct AssetLoader<MaterialDescriptor> {
+    using Intermediate = MaterialDescriptor;
+
+    static MaterialDescriptor load(const std::string &path) {
+        return XML::read_material(path);
+    }
+
+    static MaterialDescriptor parse(std::string_view contents, const std::string &path) {
+        return XML::parse_material(contents, path);
+    }
+
+    static std::string name(const MaterialDescriptor &descriptor) {
+        return descriptor.name;
+    }
+
+    static MaterialDescriptor finalize(MaterialDescriptor &&descriptor) {
+        return std::move(descriptor);
+    }
+};
+
+template <>
+struct AssetLoader<ProgramDescriptor> {
+    using Intermediate = ProgramDescriptor;
+
+    static ProgramDescriptor load(const std::string &path) {
+        return XML::read_program(path);
+    }
+
+    static ProgramDescriptor parse(std::string_view contents, const std::string &path) {
+        return XML::parse_program(contents, path);
+    }
+
+    static std::string name(const ProgramDescriptor &descriptor) {
+        return descriptor.name;
+    }
+
+    static ProgramDescriptor finalize(ProgramDescriptor &&descriptor) {
+        return std::move(descriptor);
+    }
+};
+
 }
 
 #endif // __CALICO_XML_PARSERS_HPP__
@@ -0,0 +1,317 @@
+#ifndef __CALICO_XML_PULL_PARSER_HPP__
+#define __CALICO_XML_PULL_PARSER_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "xml/parsers.hpp"
+
+namespace Calico::XML {
+
+// Streaming parser for the small subset of XML the descriptors are written in.
+//
+// `next` steps through the document one token at a time, and names, attribute values
+// and text are `string_view`s into the document, so nothing is copied or allocated
+// per node; the caller keeps the document alive. Attributes aren't split up front,
+// `attribute` scans the tag when asked. The XML declaration, comments, processing
+// instructions and `<!DOCTYPE>` are skipped, as is text that is only whitespace.
+// `<![CDATA[...]]>` sections are returned as text. Entities are not decoded.
+//
+// Malformed documents throw a `ParserError` naming `source` and the line.
+class PullParser {
+public:
+    enum class Token {
+        StartElement,
+        EndElement,
+        Text,
+        End,
+    };
+private:
+    std::string_view document;
+    std::string_view source;
+    std::size_t position = 0;
+    // start of the current token, for error messages
+    std::size_t token_start = 0;
+
+    std::string_view current_name = {};
+    std::string_view current_text = {};
+    // everything between the tag name and the closing `>` or `/>`
+    std::string_view current_attributes = {};
+    // set after the start of a self closing element, which yields an end next
+    bool pending_end = false;
+    std::vector<std::string_view> open_elements = {};
+
+    static bool is_space(char c) noexcept {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static bool ends_name(char c) noexcept {
+        return is_space(c) || c == '/' || c == '>' || c == '=';
+    }
+
+    static std::string_view trim(std::string_view text) noexcept {
+        while (!text.empty() && is_space(text.front())) {
+            text.remove_prefix(1);
+        }
+
+        while (!text.empty() && is_space(text.back())) {
+            text.remove_suffix(1);
+        }
+
+        return text;
+    }
+
+    // Move past the next `terminator`, returning what came before it
+    std::string_view skip_past(std::string_view terminator, const char *what) {
+        std::size_t end = document.find(terminator, position);
+        if (end == std::string_view::npos) {
+            error(std::string("Unterminated ") + what);
+        }
+
+        std::string_view skipped = document.substr(position, end - position);
+        position = end + terminator.size();
+        return skipped;
+    }
+
+    std::string_view read_name() {
+        std::size_t start = position;
+        while (position < document.size() && !ends_name(document[position])) {
+            position++;
+        }
+
+        if (position == start) {
+            error("Expected a name");
+        }
+
+        return document.substr(start, position - start);
+    }
+
+    Token read_start_tag() {
+        position++;
+        current_name = read_name();
+
+        // find the end of the tag, stepping over quoted attribute values since they may
+        // contain '>'
+        std::size_t attributes_start = position;
+        char quote = '\0';
+        for (; position < document.size(); position++) {
+            char c = document[position];
+            if (quote) {
+                quote = c == quote ? '\0' : quote;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                break;
+            }
+        }
+
+        if (position == document.size()) {
+            error("Unterminated tag <" + std::string(current_name) + ">");
+        }
+
+        bool self_closing = position > attributes_start && document[position - 1] == '/';
+        current_attributes = document.substr(attributes_start, position - attributes_start - self_closing);
+        position++;
+
+        if (self_closing) {
+            pending_end = true;
+        } else {
+            open_elements.push_back(current_name);
+        }
+
+        return Token::StartElement;
+    }
+
+    Token read_end_tag() {
+        position += 2;
+        current_name = read_name();
+        current_attributes = {};
+
+        while (position < document.size() && is_space(document[position])) {
+            position++;
+        }
+
+        if (position == document.size() || document[position] != '>') {
+            error("Unterminated tag </" + std::string(current_name) + ">");
+        }
+
+        position++;
+
+        if (open_elements.empty() || open_elements.back() != current_name) {
+            error("Unexpected </" + std::string(current_name) + ">");
+        }
+
+        open_elements.pop_back();
+        return Token::EndElement;
+    }
+public:
+    explicit PullParser(std::string_view document, std::string_view source = "<memory>")
+        : document(document), source(source) {
+
+        // a UTF-8 byte order mark
+        if (this->document.starts_with("\xEF\xBB\xBF")) {
+            position = 3;
+        }
+    }
+
+    Token next() {
+        if (pending_end) {
+            pending_end = false;
+            current_attributes = {};
+            return Token::EndElement;
+        }
+
+        while (position < document.size()) {
+            token_start = position;
+
+            if (document[position] != '<') {
+                std::size_t end = std::min(document.find('<', position), document.size());
+                std::string_view text = trim(document.substr(position, end - position));
+                position = end;
+
+                if (!text.empty()) {
+                    if (open_elements.empty()) {
+                        error("Text outside of the root element");
+                    }
+
+                    current_text = text;
+                    return Token::Text;
+                }
+            } else if (document.substr(position).starts_with("<!--")) {
+                position += 4;
+                skip_past("-->", "comment");
+            } else if (document.substr(position).starts_with("<![CDATA[")) {
+                position += 9;
+                current_text = skip_past("]]>", "CDATA section");
+                return Token::Text;
+            } else if (document.substr(position).starts_with("<?")) {
+                position += 2;
+                skip_past("?>", "processing instruction");
+            } else if (document.substr(position).starts_with("<!")) {
+                position += 2;
+                skip_past(">", "declaration");
+            } else if (document.substr(position).starts_with("</")) {
+                return read_end_tag();
+            } else {
+                return read_start_tag();
+            }
+        }
+
+        token_start = position;
+        if (!open_elements.empty()) {
+            error("Missing </" + std::string(open_elements.back()) + ">");
+        }
+
+        return Token::End;
+    }
+
+    // Skip the rest of the element just started, including its children, so the next
+    // token is whatever follows its end
+    void skip_element() {
+        std::size_t depth = 1;
+        while (depth > 0) {
+            switch (next()) {
+            case Token::StartElement: depth++; break;
+            case Token::EndElement: depth--; break;
+            case Token::End: return;
+            default: break;
+            }
+        }
+    }
+
+    // The text of the element just started, which mustn't contain other elements, and
+    // move past its end
+    std::string_view read_text() {
+        std::string_view element = current_name;
+        switch (next()) {
+        case Token::EndElement:
+            return {};
+        case Token::Text: {
+            std::string_view text = current_text;
+            if (next() != Token::EndElement) {
+                error("Expected only text in <" + std::string(element) + ">");
+            }
+
+            return text;
+        }
+        default:
+            error("Expected only text in <" + std::string(element) + ">");
+        }
+    }
+
+    // Name of the element of the last `StartElement` or `EndElement`
+    std::string_view name() const noexcept {
+        return current_name;
+    }
+
+    // Text of the last `Text`, without surrounding whitespace
+    std::string_view text() const noexcept {
+        return current_text;
+    }
+
+    // Value of attribute `key` of the element just started
+    std::optional<std::string_view> attribute(std::string_view key) const {
+        std::string_view rest = current_attributes;
+
+        while (true) {
+            rest = trim(rest);
+            if (rest.empty()) {
+                return std::nullopt;
+            }
+
+            std::size_t name_end = 0;
+            while (name_end < rest.size() && !ends_name(rest[name_end])) {
+                name_end++;
+            }
+
+            std::string_view name = rest.substr(0, name_end);
+            rest = trim(rest.substr(name_end));
+            if (name.empty() || rest.empty() || rest.front() != '=') {
+                error("Malformed attributes in <" + std::string(current_name) + ">");
+            }
+
+            rest = trim(rest.substr(1));
+            if (rest.empty() || (rest.front() != '"' && rest.front() != '\'')) {
+                error("Unquoted attribute '" + std::string(name) + "'");
+            }
+
+            std::size_t value_end = rest.find(rest.front(), 1);
+            if (value_end == std::string_view::npos) {
+                error("Unterminated attribute '" + std::string(name) + "'");
+            }
+
+            if (name == key) {
+                return rest.substr(1, value_end - 1);
+            }
+
+            rest = rest.substr(value_end + 1);
+        }
+    }
+
+    // Like `attribute`, but throws if it's missing
+    std::string_view required_attribute(std::string_view key) const {
+        auto value = attribute(key);
+        if (!value) {
+            error("<" + std::string(current_name) + "> is missing attribute '" + std::string(key) + "'");
+        }
+
+        return *value;
+    }
+
+    // Line of the current token, counted from 1
+    std::size_t line() const noexcept {
+        return 1 + std::count(document.begin(), document.begin() + std::min(token_start, document.size()), '\n');
+    }
+
+    [[noreturn]] void error(const std::string &message) const {
+        throw ParserError(std::string(source) + ":" + std::to_string(line()) + ": " + message);
+    }
+};
+
+}
+
+#endif // __CALICO_XML_PULL_PARSER_HPP__